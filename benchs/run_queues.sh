@@ -0,0 +1,36 @@
+#!/bin/bash
+# Compares the lock-free work stealing deque with the locked queue of moving nodes.
+# Builds the virtual machine once for each queue and runs the programs with both.
+
+SCHEDULER="${1}"
+STEP="${2}"
+MIN="${3}"
+MAX="${4}"
+RUNS="${5}"
+
+rm -f $RESULTS_FILE
+source $PWD/lib/common.sh
+
+build_vm () {
+   MODE="$1"
+   CURRENT_DIR="$PWD"
+   echo -n "=> Compiling the virtual machine (STEALING_DEQUE=$MODE)..."
+   cd ..
+   make clean 2>&1 > /dev/null || exit 1
+   make STEALING_DEQUE=$MODE -j$CPUS meld 2>&1 > /dev/null || exit 1
+   mv meld $CURRENT_DIR/meld-deque-$MODE
+   echo -en "\r\033[K"
+   cd $CURRENT_DIR
+}
+
+build_vm true
+build_vm false
+# leave the default virtual machine in place.
+(cd .. && make clean 2>&1 > /dev/null && make -j$CPUS 2>&1 > /dev/null)
+
+for x in ${*:6}; do
+   bash threads_even.sh "./meld-deque-true -f code/$x.m" "$x-deque" $SCHEDULER $STEP $MIN $MAX $RUNS
+   bash threads_even.sh "./meld-deque-false -f code/$x.m" "$x-locked" $SCHEDULER $STEP $MIN $MAX $RUNS
+done
+
+rm -f meld-deque-true meld-deque-false
@@ -7,6 +7,10 @@ ALLOCATOR = pool
 # ticket: use ticket spinlock.
 # queued: use MCS queued spin lock.
 LOCK_ALGORITHM = queued
+# allocate facts from an arena owned by each node (requires the pool allocator).
+NODE_ALLOCATOR = true
+# store linear facts with only int, float or node arguments in columns.
+COLUMNAR_STORE = true
 # Use 'true' for dynamic indexing of facts.
 INDEXING = false
 # Make the virtual machine use the node pointers in predicate arguments
@@ -15,6 +19,11 @@ INDEXING = false
 USE_ADDRESSES = true
 # allow threads to steal nodes from each other.
 TASK_STEALING = true
+# use a lock-free work stealing deque for the queue of moving nodes
+# instead of a queue protected by a lock.
+STEALING_DEQUE = true
+# idle threads sleep on a futex instead of spinning until work arrives.
+IDLE_PARKING = true
 # enable node collection if the node is no longer referenced anywhere.
 GC_NODES = true
 # activate fact buffering (only send facts after the node has completed running)
@@ -1,5 +1,8 @@
 
+#include <vector>
+
 #include "db/agg_configuration.hpp"
+#include "db/agg_reduce.hpp"
 
 using namespace std;
 using namespace vm;
@@ -23,12 +26,15 @@ agg_configuration::add_to_set(vm::tuple *tpl, vm::predicate *pred,
       case POSITIVE_DERIVATION:
          if(!vals.insert_tuple(tpl, pred, depth)) {
             // repeated tuple
+            update_running(tpl, pred, false);
             vm::tuple::destroy(tpl, pred, alloc, gc_nodes);
-         }
+         } else
+            update_running(tpl, pred, true);
 
          assert(vals.size() == start_size + 1);
          break;
       case NEGATIVE_DERIVATION:
+         running_valid = false;
          // to delete
          trie::delete_info deleter(vals.delete_tuple(tpl, pred, depth)); // note the minus sign
          if(!deleter.is_valid()) {
@@ -96,62 +102,145 @@ agg_configuration::matches_first_int_arg(predicate *pred, const int_val val) con
    return other->get_int(0) == val;
 }
 
-vm::tuple*
-agg_configuration::generate_max_int(predicate *pred, const field_num field, vm::depth_t& depth,
-      mem::node_allocator *alloc) const
+void
+agg_configuration::update_running(vm::tuple *tpl, predicate *pred, const bool is_new)
 {
-   assert(!vals.empty());
+   if(!running_valid)
+      return;
 
-   const_iterator end(vals.end());
-   const_iterator it(vals.begin());
-   tuple_trie_leaf *leaf(*it);
-   vm::tuple *max_tpl(leaf->get_underlying_tuple());
-   int_val max_val(max_tpl->get_int(field));
+   const field_num field(pred->get_aggregate_field());
 
-   depth = max(depth, leaf->get_max_depth());
+   switch(pred->get_aggregate_type()) {
+      case AGG_FIRST:
+         break;
+      case AGG_SUM_INT:
+         FIELD_INT(running_val) += tpl->get_int(field);
+         break;
+      case AGG_SUM_FLOAT:
+         // repeated tuples are added next to their first copy when
+         // the sum is computed, which would round differently.
+         if(is_new)
+            FIELD_FLOAT(running_val) += tpl->get_float(field);
+         else
+            running_valid = false;
+         break;
+      // new tuples go to the end of the trie, therefore they must be
+      // strictly better to replace the current tuple.
+      case AGG_MAX_INT:
+         if(is_new && tpl->get_int(field) > running_tpl->get_int(field))
+            running_tpl = tpl;
+         break;
+      case AGG_MIN_INT:
+         if(is_new && tpl->get_int(field) < running_tpl->get_int(field))
+            running_tpl = tpl;
+         break;
+      case AGG_MAX_FLOAT:
+         if(is_new && tpl->get_float(field) > running_tpl->get_float(field))
+            running_tpl = tpl;
+         break;
+      case AGG_MIN_FLOAT:
+         if(is_new && tpl->get_float(field) < running_tpl->get_float(field))
+            running_tpl = tpl;
+         break;
+      default:
+         running_valid = false;
+         break;
+   }
+}
 
-   ++it;
-   for(; it != end; ++it)
-   {
-      tuple_trie_leaf *sother(*it);
-      vm::tuple *other(sother->get_underlying_tuple());
+void
+agg_configuration::set_running(predicate *pred, const aggregate_type typ,
+      const field_num field, vm::tuple *generated)
+{
+   // depths of cyclic predicates are not tracked incrementally.
+   running_valid = !pred->is_cycle_pred();
 
-      depth = max(depth, sother->get_max_depth());
-      if(max_val < other->get_int(field)) {
-         max_val = other->get_int(field);
-         max_tpl = other;
-      }
+   switch(typ) {
+      case AGG_SUM_INT:
+      case AGG_SUM_FLOAT:
+         running_val = generated->get_field(field);
+         break;
+      case AGG_FIRST:
+         running_tpl = (*vals.begin())->get_underlying_tuple();
+         break;
+      case AGG_MAX_INT:
+      case AGG_MIN_INT:
+      case AGG_MAX_FLOAT:
+      case AGG_MIN_FLOAT:
+         // running_tpl was set by the generate function.
+         break;
+      default:
+         running_valid = false;
+         break;
    }
-
-   return max_tpl->copy(pred, alloc);
 }
 
 vm::tuple*
-agg_configuration::generate_min_int(predicate *pred, const field_num field, vm::depth_t& depth,
-      mem::node_allocator *alloc) const
+agg_configuration::generate_running(predicate *pred, const aggregate_type typ,
+      const field_num field, mem::node_allocator *alloc) const
 {
-   assert(!vals.empty());
-   
-   const_iterator end(vals.end());
-   const_iterator it(vals.begin());
-   tuple_trie_leaf *leaf(*it);
-   vm::tuple *min_tpl(leaf->get_underlying_tuple());
-   int_val min_val(min_tpl->get_int(field));
+   switch(typ) {
+      case AGG_SUM_INT: {
+         vm::tuple *ret((*vals.begin())->get_underlying_tuple()->copy(pred, alloc));
+         ret->set_int(field, FIELD_INT(running_val));
+         return ret;
+      }
+      case AGG_SUM_FLOAT: {
+         vm::tuple *ret((*vals.begin())->get_underlying_tuple()->copy(pred, alloc));
+         ret->set_float(field, FIELD_FLOAT(running_val));
+         return ret;
+      }
+      default:
+         return running_tpl->copy(pred, alloc);
+   }
+}
 
-   depth = max(depth, leaf->get_max_depth());
+// values of the aggregated field are gathered into a contiguous buffer
+// and then reduced with the kernels in db/agg_reduce.hpp.
+static thread_local vector<vm::tuple*> gather_tuples;
+static thread_local vector<int_val> gather_ints;
+static thread_local vector<float_val> gather_floats;
 
-   ++it;
-   for(; it != end; ++it) {
-      tuple_trie_leaf *sother(*it);
-      vm::tuple *other(sother->get_underlying_tuple());
+template <typename T, typename G, typename R>
+static inline vm::tuple*
+generate_extreme(const tuple_trie& vals, const field_num field, vm::depth_t& depth,
+      vector<T>& buf, G get, R reduce)
+{
+   assert(!vals.empty());
 
-      depth = max(depth, sother->get_max_depth());
-      if(min_val > other->get_int(field)) {
-         min_val = other->get_int(field);
-         min_tpl = other;
-      }
+   gather_tuples.clear();
+   buf.clear();
+   for(tuple_trie::const_iterator it(vals.begin()), end(vals.end()); it != end; ++it) {
+      tuple_trie_leaf *leaf(*it);
+      vm::tuple *tpl(leaf->get_underlying_tuple());
+
+      depth = max(depth, leaf->get_max_depth());
+      gather_tuples.push_back(tpl);
+      buf.push_back(get(tpl, field));
    }
 
+   return gather_tuples[reduce(buf.data(), buf.size())];
+}
+
+vm::tuple*
+agg_configuration::generate_max_int(predicate *pred, const field_num field, vm::depth_t& depth,
+      mem::node_allocator *alloc)
+{
+   vm::tuple *max_tpl(generate_extreme(vals, field, depth, gather_ints,
+            [](vm::tuple *tpl, const field_num f) { return tpl->get_int(f); },
+            agg_reduce_max_int));
+   running_tpl = max_tpl;
+   return max_tpl->copy(pred, alloc);
+}
+
+vm::tuple*
+agg_configuration::generate_min_int(predicate *pred, const field_num field, vm::depth_t& depth,
+      mem::node_allocator *alloc)
+{
+   vm::tuple *min_tpl(generate_extreme(vals, field, depth, gather_ints,
+            [](vm::tuple *tpl, const field_num f) { return tpl->get_int(f); },
+            agg_reduce_min_int));
+   running_tpl = min_tpl;
    return min_tpl->copy(pred, alloc);
 }
 
@@ -226,59 +315,23 @@ agg_configuration::generate_first(predicate *pred, vm::depth_t& depth, mem::node
 
 vm::tuple*
 agg_configuration::generate_max_float(predicate *pred, const field_num field, vm::depth_t& depth,
-      mem::node_allocator *alloc) const
+      mem::node_allocator *alloc)
 {
-   assert(!vals.empty());
-   
-   const_iterator end(vals.end());
-   const_iterator it(vals.begin());
-   tuple_trie_leaf *leaf(*it);
-   vm::tuple *max_tpl(leaf->get_underlying_tuple());
-   float_val max_val(max_tpl->get_float(field));
-
-   depth = max(depth, leaf->get_max_depth());
-
-   ++it;
-   for(; it != end; ++it) {
-      tuple_trie_leaf *sother(*it);
-      vm::tuple *other(sother->get_underlying_tuple());
-
-      depth = max(sother->get_max_depth(), depth);
-      if(max_val < other->get_float(field)) {
-         max_val = other->get_float(field);
-         max_tpl = other;
-      }
-   }
-
+   vm::tuple *max_tpl(generate_extreme(vals, field, depth, gather_floats,
+            [](vm::tuple *tpl, const field_num f) { return tpl->get_float(f); },
+            agg_reduce_max_float));
+   running_tpl = max_tpl;
    return max_tpl->copy(pred, alloc);
 }
 
 vm::tuple*
 agg_configuration::generate_min_float(predicate *pred, const field_num field, vm::depth_t& depth,
-      mem::node_allocator *alloc) const
+      mem::node_allocator *alloc)
 {
-   assert(!vals.empty());
-   
-   const_iterator end(vals.end());
-   const_iterator it(vals.begin());
-   tuple_trie_leaf *leaf(*it);
-   vm::tuple *min_tpl(leaf->get_underlying_tuple());
-   float_val min_val(min_tpl->get_float(field));
-
-   depth = max(depth, leaf->get_max_depth());
-
-   ++it;
-   for(; it != end; ++it) {
-      tuple_trie_leaf *sother(*it);
-      vm::tuple *other(sother->get_underlying_tuple());
-
-      depth = max(sother->get_max_depth(), depth);
-      if(min_val > other->get_float(field)) {
-         min_val = other->get_float(field);
-         min_tpl = other;
-      }
-   }
-
+   vm::tuple *min_tpl(generate_extreme(vals, field, depth, gather_floats,
+            [](vm::tuple *tpl, const field_num f) { return tpl->get_float(f); },
+            agg_reduce_min_float));
+   running_tpl = min_tpl;
    return min_tpl->copy(pred, alloc);
 }
 
@@ -338,30 +391,47 @@ vm::tuple*
 agg_configuration::do_generate(predicate *pred, const aggregate_type typ, const field_num field,
       vm::depth_t& depth, mem::node_allocator *alloc)
 {
-   if(vals.empty())
+   if(vals.empty()) {
+      running_valid = false;
       return nullptr;
+   }
+
+   if(running_valid)
+      return generate_running(pred, typ, field, alloc);
+
+   vm::tuple *ret(nullptr);
 
    switch(typ) {
       case AGG_FIRST:
-         return generate_first(pred, depth, alloc);
+         ret = generate_first(pred, depth, alloc);
+         break;
       case AGG_MAX_INT:
-         return generate_max_int(pred, field, depth, alloc);
+         ret = generate_max_int(pred, field, depth, alloc);
+         break;
       case AGG_MIN_INT:
-         return generate_min_int(pred, field, depth, alloc);
+         ret = generate_min_int(pred, field, depth, alloc);
+         break;
       case AGG_SUM_INT:
-         return generate_sum_int(pred, field, depth, alloc);
+         ret = generate_sum_int(pred, field, depth, alloc);
+         break;
       case AGG_SUM_FLOAT:
-         return generate_sum_float(pred, field, depth, alloc);
+         ret = generate_sum_float(pred, field, depth, alloc);
+         break;
       case AGG_MAX_FLOAT:
-         return generate_max_float(pred, field, depth, alloc);
+         ret = generate_max_float(pred, field, depth, alloc);
+         break;
       case AGG_MIN_FLOAT:
-         return generate_min_float(pred, field, depth, alloc);
+         ret = generate_min_float(pred, field, depth, alloc);
+         break;
       case AGG_SUM_LIST_FLOAT:
-         return generate_sum_list_float(pred, field, depth, alloc);
+         ret = generate_sum_list_float(pred, field, depth, alloc);
+         break;
    }
-   
-   assert(false);
-   return nullptr;
+
+   assert(ret != nullptr);
+   set_running(pred, typ, field, ret);
+
+   return ret;
 }
 
 void
@@ -411,12 +481,9 @@ agg_configuration::print(ostream& cout, predicate *pred) const
       cout << leaf->get_count();
       if(leaf->has_depth_counter()) {
          cout << " - ";
-         for(auto it(leaf->get_depth_begin()), end(leaf->get_depth_end());
-               it != end;
-               ++it)
-         {
-            cout << "(" << it->first << "x" << it->second << ")";
-         }
+         leaf->get_depth_counter()->for_each([&cout](const depth_t depth, const ref_count count) {
+            cout << "(" << depth << "x" << count << ")";
+         });
       }
       cout << endl;
    }
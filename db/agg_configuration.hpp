@@ -24,14 +24,26 @@ private:
    bool changed;
    vm::tuple *corresponds;
    vm::depth_t last_depth;
+
+   // the value of the aggregate is kept up to date while tuples are added
+   // so that generate does not need to go through all the tuples.
+   // deletions invalidate it until the aggregate is computed again.
+   bool running_valid{false};
+   vm::tuple_field running_val;
+   vm::tuple *running_tpl{nullptr};
+
+   void update_running(vm::tuple *, vm::predicate *, const bool);
+   vm::tuple *generate_running(vm::predicate *, const vm::aggregate_type,
+         const vm::field_num, mem::node_allocator *) const;
+   void set_running(vm::predicate *, const vm::aggregate_type, const vm::field_num, vm::tuple *);
    
-   vm::tuple *generate_max_int(vm::predicate *, const vm::field_num, vm::depth_t&, mem::node_allocator *) const;
-   vm::tuple *generate_min_int(vm::predicate *, const vm::field_num, vm::depth_t&, mem::node_allocator *) const;
+   vm::tuple *generate_max_int(vm::predicate *, const vm::field_num, vm::depth_t&, mem::node_allocator *);
+   vm::tuple *generate_min_int(vm::predicate *, const vm::field_num, vm::depth_t&, mem::node_allocator *);
    vm::tuple *generate_sum_int(vm::predicate *, const vm::field_num, vm::depth_t&, mem::node_allocator *) const;
    vm::tuple *generate_sum_float(vm::predicate *, const vm::field_num, vm::depth_t&, mem::node_allocator *) const;
    vm::tuple *generate_first(vm::predicate *, vm::depth_t&, mem::node_allocator *) const;
-   vm::tuple *generate_max_float(vm::predicate *, const vm::field_num, vm::depth_t&, mem::node_allocator *) const;
-   vm::tuple *generate_min_float(vm::predicate *, const vm::field_num, vm::depth_t&, mem::node_allocator *) const;
+   vm::tuple *generate_max_float(vm::predicate *, const vm::field_num, vm::depth_t&, mem::node_allocator *);
+   vm::tuple *generate_min_float(vm::predicate *, const vm::field_num, vm::depth_t&, mem::node_allocator *);
    vm::tuple *generate_sum_list_float(vm::predicate *, const vm::field_num, vm::depth_t&, mem::node_allocator *) const;
    
 protected:
@@ -69,6 +81,7 @@ public:
    inline void wipeout(vm::predicate *pred, mem::node_allocator *alloc, vm::candidate_gc_nodes& gc_nodes)
    {
       vals.wipeout(pred, alloc, gc_nodes);
+      running_valid = false;
       if(corresponds) {
          vm::tuple::destroy(corresponds, pred, alloc, gc_nodes);
          corresponds = nullptr;
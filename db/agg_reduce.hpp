@@ -0,0 +1,160 @@
+
+#ifndef DB_AGG_REDUCE_HPP
+#define DB_AGG_REDUCE_HPP
+
+#include <cstddef>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "vm/defs.hpp"
+
+namespace db {
+
+// Min/max reductions over the values of an aggregate once they have been
+// gathered into a contiguous buffer.
+// Each function returns the position of the first extreme value, just like
+// a scalar loop that only replaces the current value when the new one is
+// strictly better. n must be greater than 0.
+
+// kernels compute the extreme value and then look for its first position.
+// if nothing is equal to the value (a NaN) we fall back to the scalar loop.
+#define AGG_REDUCE_FIND(VALS, N, BEST, BETTER)          \
+   for (size_t i(0); i < (N); ++i)                     \
+      if ((VALS)[i] == (BEST)) return i;               \
+   size_t pos(0);                                      \
+   for (size_t i(1); i < (N); ++i)                     \
+      if ((VALS)[pos] BETTER(VALS)[i]) pos = i;        \
+   return pos
+
+inline size_t agg_reduce_max_float(const vm::float_val *vals, const size_t n) {
+   vm::float_val best(vals[0]);
+   size_t i(0);
+#if defined(__AVX2__)
+   if (n >= 4) {
+      __m256d acc(_mm256_set1_pd(best));
+      for (; i + 4 <= n; i += 4) acc = _mm256_max_pd(_mm256_loadu_pd(vals + i), acc);
+      double tmp[4];
+      _mm256_storeu_pd(tmp, acc);
+      for (size_t j(0); j < 4; ++j)
+         if (best < tmp[j]) best = tmp[j];
+   }
+#elif defined(__SSE2__)
+   if (n >= 2) {
+      __m128d acc(_mm_set1_pd(best));
+      for (; i + 2 <= n; i += 2) acc = _mm_max_pd(_mm_loadu_pd(vals + i), acc);
+      double tmp[2];
+      _mm_storeu_pd(tmp, acc);
+      for (size_t j(0); j < 2; ++j)
+         if (best < tmp[j]) best = tmp[j];
+   }
+#endif
+   for (; i < n; ++i)
+      if (best < vals[i]) best = vals[i];
+   AGG_REDUCE_FIND(vals, n, best, <);
+}
+
+inline size_t agg_reduce_min_float(const vm::float_val *vals, const size_t n) {
+   vm::float_val best(vals[0]);
+   size_t i(0);
+#if defined(__AVX2__)
+   if (n >= 4) {
+      __m256d acc(_mm256_set1_pd(best));
+      for (; i + 4 <= n; i += 4) acc = _mm256_min_pd(_mm256_loadu_pd(vals + i), acc);
+      double tmp[4];
+      _mm256_storeu_pd(tmp, acc);
+      for (size_t j(0); j < 4; ++j)
+         if (best > tmp[j]) best = tmp[j];
+   }
+#elif defined(__SSE2__)
+   if (n >= 2) {
+      __m128d acc(_mm_set1_pd(best));
+      for (; i + 2 <= n; i += 2) acc = _mm_min_pd(_mm_loadu_pd(vals + i), acc);
+      double tmp[2];
+      _mm_storeu_pd(tmp, acc);
+      for (size_t j(0); j < 2; ++j)
+         if (best > tmp[j]) best = tmp[j];
+   }
+#endif
+   for (; i < n; ++i)
+      if (best > vals[i]) best = vals[i];
+   AGG_REDUCE_FIND(vals, n, best, >);
+}
+
+#if defined(__SSE2__) && !defined(__AVX2__)
+// SSE2 has no 32 bit min/max, so we select with a compare mask.
+inline __m128i agg_select_epi32(const __m128i mask, const __m128i a, const __m128i b) {
+   return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+#endif
+
+inline size_t agg_reduce_max_int(const vm::int_val *vals, const size_t n) {
+   vm::int_val best(vals[0]);
+   size_t i(0);
+#if defined(__AVX2__)
+   if (n >= 8) {
+      __m256i acc(_mm256_set1_epi32(best));
+      for (; i + 8 <= n; i += 8)
+         acc = _mm256_max_epi32(_mm256_loadu_si256((const __m256i *)(vals + i)), acc);
+      vm::int_val tmp[8];
+      _mm256_storeu_si256((__m256i *)tmp, acc);
+      for (size_t j(0); j < 8; ++j)
+         if (best < tmp[j]) best = tmp[j];
+   }
+#elif defined(__SSE2__)
+   if (n >= 4) {
+      __m128i acc(_mm_set1_epi32(best));
+      for (; i + 4 <= n; i += 4) {
+         const __m128i x(_mm_loadu_si128((const __m128i *)(vals + i)));
+         acc = agg_select_epi32(_mm_cmpgt_epi32(x, acc), x, acc);
+      }
+      vm::int_val tmp[4];
+      _mm_storeu_si128((__m128i *)tmp, acc);
+      for (size_t j(0); j < 4; ++j)
+         if (best < tmp[j]) best = tmp[j];
+   }
+#endif
+   for (; i < n; ++i)
+      if (best < vals[i]) best = vals[i];
+   AGG_REDUCE_FIND(vals, n, best, <);
+}
+
+inline size_t agg_reduce_min_int(const vm::int_val *vals, const size_t n) {
+   vm::int_val best(vals[0]);
+   size_t i(0);
+#if defined(__AVX2__)
+   if (n >= 8) {
+      __m256i acc(_mm256_set1_epi32(best));
+      for (; i + 8 <= n; i += 8)
+         acc = _mm256_min_epi32(_mm256_loadu_si256((const __m256i *)(vals + i)), acc);
+      vm::int_val tmp[8];
+      _mm256_storeu_si256((__m256i *)tmp, acc);
+      for (size_t j(0); j < 8; ++j)
+         if (best > tmp[j]) best = tmp[j];
+   }
+#elif defined(__SSE2__)
+   if (n >= 4) {
+      __m128i acc(_mm_set1_epi32(best));
+      for (; i + 4 <= n; i += 4) {
+         const __m128i x(_mm_loadu_si128((const __m128i *)(vals + i)));
+         acc = agg_select_epi32(_mm_cmplt_epi32(x, acc), x, acc);
+      }
+      vm::int_val tmp[4];
+      _mm_storeu_si128((__m128i *)tmp, acc);
+      for (size_t j(0); j < 4; ++j)
+         if (best > tmp[j]) best = tmp[j];
+   }
+#endif
+   for (; i < n; ++i)
+      if (best > vals[i]) best = vals[i];
+   AGG_REDUCE_FIND(vals, n, best, >);
+}
+
+#undef AGG_REDUCE_FIND
+
+}
+
+#endif
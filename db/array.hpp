@@ -4,6 +4,8 @@
 
 #include <vector>
 #include <string>
+#include <algorithm>
+#include <numeric>
 
 #include "vm/predicate.hpp"
 #include "vm/tuple.hpp"
@@ -14,15 +16,26 @@ namespace db {
 
 struct array {
    vm::tuple_field *data{nullptr};
+   // tuple positions sorted by the first argument.
+   uint16_t *order{nullptr};
    uint16_t cap{0};
    uint16_t num_tuples{0};
+   uint16_t order_size{0};
+   // compact facts are derived when the node starts and are never deleted,
+   // so the order is computed once and then used for binary searches.
+   bool frozen{false};
+
+#define ARRAY_MIN_ORDER 8
 
    struct iterator {
-      vm::tuple_field *ptr{nullptr};
+      vm::tuple_field *data{nullptr};
+      const uint16_t *order{nullptr};
+      size_t pos{0};
       size_t step{0};
 
       inline vm::tuple *operator*() {
-         assert(ptr);
+         assert(data);
+         vm::tuple_field *ptr(data + step * (order ? order[pos] : pos));
          vm::tuple *tpl(
              (vm::tuple *)(((utils::byte *)ptr) - sizeof(vm::tuple)));
          assert(tpl->getfp() == ptr);
@@ -30,7 +43,7 @@ struct array {
       }
 
       inline bool operator==(const iterator &other) const {
-         return ptr == other.ptr;
+         return pos == other.pos;
       }
 
       inline bool operator!=(const iterator &other) const {
@@ -38,20 +51,21 @@ struct array {
       }
 
       inline iterator &operator++() {
-         assert(ptr);
-         ptr += step;
+         assert(data);
+         pos++;
          return *this;
       }
 
       inline iterator operator++(int) {
-         assert(ptr);
-         ptr += step;
+         assert(data);
+         pos++;
          return *this;
       }
 
       explicit inline iterator(const size_t start, const size_t num_args,
-                               vm::tuple_field *data)
-          : ptr(data ? (data + num_args * start) : nullptr), step(num_args) {}
+                               vm::tuple_field *_data,
+                               const uint16_t *_order = nullptr)
+          : data(_data), order(_order), pos(start), step(num_args) {}
    };
 
    inline iterator begin(const vm::predicate *pred) {
@@ -77,11 +91,11 @@ struct array {
       const size_t size(compute_size(pred, _cap));
       num_tuples = 0;
       cap = _cap;
-      if (num_tuples < 16)
+      if (cap < 16)
          data = (vm::tuple_field *)alloc->allocate_obj(size);
       else
          data =
-             (vm::tuple_field *)mem::allocator<utils::byte *>().allocate(size);
+             (vm::tuple_field *)mem::allocator<utils::byte>().allocate(size);
    }
 
    inline vm::tuple* expand(const vm::predicate *pred, mem::node_allocator *alloc) {
@@ -93,6 +107,7 @@ struct array {
             utils::byte *old((utils::byte *)data);
             init(cap * 2, pred, alloc);
             memcpy(data, old, compute_size(pred, old_cap));
+            num_tuples = old_cap;
             delete_buffer(pred, old, old_cap, alloc);
          }
       }
@@ -100,6 +115,7 @@ struct array {
    }
 
    inline vm::tuple *add_next(const vm::predicate *pred) {
+      frozen = false;
       vm::tuple *tpl(
           (vm::tuple *)(((utils::byte *)(data + num_tuples * pred->num_fields())) -
                         sizeof(vm::tuple)));
@@ -110,6 +126,72 @@ struct array {
 
    inline size_t size() const { return num_tuples; }
 
+   inline bool has_order(void) const { return frozen && order; }
+
+   static inline bool can_order(const vm::predicate *pred) {
+      if (pred->num_fields() == 0) return false;
+      switch (pred->get_field_type(0)->get_type()) {
+         case vm::FIELD_INT:
+         case vm::FIELD_NODE:
+            return true;
+         default:
+            return false;
+      }
+   }
+
+   static inline bool field_less(const vm::field_type t,
+                                 const vm::tuple_field &a,
+                                 const vm::tuple_field &b) {
+      if (t == vm::FIELD_INT) return FIELD_INT(a) < FIELD_INT(b);
+      return FIELD_NODE(a) < FIELD_NODE(b);
+   }
+
+   // sorts the positions of the tuples by the first argument.
+   // the tuples are not moved so that iteration order is kept.
+   inline void freeze(const vm::predicate *pred) {
+      frozen = true;
+      delete_order();
+      if (num_tuples < ARRAY_MIN_ORDER || !can_order(pred)) return;
+
+      const size_t n(pred->num_fields());
+      const vm::field_type t(pred->get_field_type(0)->get_type());
+      order_size = num_tuples;
+      order = mem::allocator<uint16_t>().allocate(order_size);
+      std::iota(order, order + order_size, 0);
+      std::stable_sort(order, order + order_size,
+                       [this, n, t](const uint16_t a, const uint16_t b) {
+                          return field_less(t, data[a * n], data[b * n]);
+                       });
+   }
+
+   // returns the tuples whose first argument is equal to 'key'.
+   inline std::pair<iterator, iterator> equal_range(
+       const vm::predicate *pred, const vm::tuple_field &key) const {
+      assert(has_order());
+      const size_t n(pred->num_fields());
+      const vm::field_type t(pred->get_field_type(0)->get_type());
+      auto key_less = [this, n, t](const uint16_t a, const vm::tuple_field &k) {
+         return field_less(t, data[a * n], k);
+      };
+      auto key_greater = [this, n, t](const vm::tuple_field &k, const uint16_t a) {
+         return field_less(t, k, data[a * n]);
+      };
+      const uint16_t *first(
+          std::lower_bound(order, order + order_size, key, key_less));
+      const uint16_t *last(
+          std::upper_bound(first, (const uint16_t *)order + order_size, key,
+                           key_greater));
+      return std::make_pair(iterator(first - order, n, data, order),
+                            iterator(last - order, n, data, order));
+   }
+
+   inline void delete_order(void) {
+      if (!order) return;
+      mem::allocator<uint16_t>().deallocate(order, order_size);
+      order = nullptr;
+      order_size = 0;
+   }
+
    std::vector<std::string> get_print_strings(const vm::predicate *pred) const {
       std::vector<std::string> vec;
       for (auto it(begin(pred)), e(end(pred)); it != e; ++it) {
@@ -124,6 +206,8 @@ struct array {
                        vm::candidate_gc_nodes &gc_nodes) {
       if (!data) return;
 
+      delete_order();
+
       for (auto it(begin(pred)), e(end(pred)); it != e; ++it) {
          vm::tuple *tpl(*it);
          tpl->destructor(pred, gc_nodes);
@@ -0,0 +1,145 @@
+
+#include <vector>
+
+#include "db/array.hpp"
+
+class DbArrayTests : public TestFixture {
+   public:
+
+#define ARRAY_TEST_TUPLES 100
+#define ARRAY_TEST_KEYS 10
+
+      vm::predicate *f;
+
+      void setUp(void)
+      {
+         std::vector<vm::type*> types;
+         types.push_back(vm::TYPE_INT);
+         types.push_back(vm::TYPE_INT);
+         f = vm::predicate::make_predicate_simple(0, "f", true, types);
+      }
+
+      static vm::tuple_field make_key(const vm::int_val v)
+      {
+         vm::tuple_field k;
+         SET_FIELD_INT(k, v);
+         return k;
+      }
+
+      size_t count_key(const db::array& a, const vm::int_val key)
+      {
+         auto range(a.equal_range(f, make_key(key)));
+         size_t ret(0);
+         for(auto it(range.first); it != range.second; ++it)
+            ret++;
+         return ret;
+      }
+
+      void testFreeze(void)
+      {
+         mem::node_allocator alloc;
+         db::array a;
+
+         // tuple i has key (i * 7) % 10 and value i.
+         for(size_t i(0); i < ARRAY_TEST_TUPLES; ++i) {
+            vm::tuple *tpl(a.expand(f, &alloc));
+            tpl->set_int(0, (vm::int_val)((i * 7) % ARRAY_TEST_KEYS));
+            tpl->set_int(1, (vm::int_val)i);
+         }
+         CPPUNIT_ASSERT(a.size() == ARRAY_TEST_TUPLES);
+         CPPUNIT_ASSERT(!a.has_order());
+
+         a.freeze(f);
+         CPPUNIT_ASSERT(a.has_order());
+
+         // iteration keeps the insertion order.
+         size_t i(0);
+         for(auto it(a.begin(f)), e(a.end(f)); it != e; ++it, ++i) {
+            CPPUNIT_ASSERT((*it)->get_int(1) == (vm::int_val)i);
+            CPPUNIT_ASSERT((*it)->get_int(0) == (vm::int_val)((i * 7) % ARRAY_TEST_KEYS));
+         }
+         CPPUNIT_ASSERT(i == ARRAY_TEST_TUPLES);
+
+         for(vm::int_val key(0); key < ARRAY_TEST_KEYS; ++key) {
+            auto range(a.equal_range(f, make_key(key)));
+            size_t found(0);
+            vm::int_val last(-1);
+            for(auto it(range.first); it != range.second; ++it) {
+               CPPUNIT_ASSERT((*it)->get_int(0) == key);
+               // duplicate keys stay in insertion order.
+               CPPUNIT_ASSERT((*it)->get_int(1) > last);
+               last = (*it)->get_int(1);
+               found++;
+            }
+            CPPUNIT_ASSERT(found == ARRAY_TEST_TUPLES / ARRAY_TEST_KEYS);
+         }
+
+         // misses before and after the keys.
+         CPPUNIT_ASSERT(count_key(a, -1) == 0);
+         CPPUNIT_ASSERT(count_key(a, ARRAY_TEST_KEYS) == 0);
+
+         // adding a tuple drops the order.
+         vm::tuple *tpl(a.expand(f, &alloc));
+         tpl->set_int(0, 0);
+         tpl->set_int(1, ARRAY_TEST_TUPLES);
+         CPPUNIT_ASSERT(!a.has_order());
+         CPPUNIT_ASSERT(a.size() == ARRAY_TEST_TUPLES + 1);
+
+         vm::candidate_gc_nodes gc_nodes;
+         a.wipeout(f, &alloc, gc_nodes);
+      }
+
+      void testGaps(void)
+      {
+         mem::node_allocator alloc;
+         db::array a;
+
+         // even keys only.
+         for(size_t i(0); i < ARRAY_TEST_TUPLES; ++i) {
+            vm::tuple *tpl(a.expand(f, &alloc));
+            tpl->set_int(0, (vm::int_val)(2 * (ARRAY_TEST_TUPLES - i)));
+            tpl->set_int(1, (vm::int_val)i);
+         }
+         a.freeze(f);
+         for(vm::int_val key(0); key <= 2 * ARRAY_TEST_TUPLES + 1; ++key) {
+            // misses between the keys.
+            if(key % 2 == 1 || key == 0) {
+               CPPUNIT_ASSERT(count_key(a, key) == 0);
+               continue;
+            }
+            auto range(a.equal_range(f, make_key(key)));
+            CPPUNIT_ASSERT(range.first != range.second);
+            CPPUNIT_ASSERT((*range.first)->get_int(1) == (vm::int_val)(ARRAY_TEST_TUPLES - key / 2));
+            CPPUNIT_ASSERT(count_key(a, key) == 1);
+         }
+
+         vm::candidate_gc_nodes gc_nodes;
+         a.wipeout(f, &alloc, gc_nodes);
+      }
+
+      void testSmall(void)
+      {
+         mem::node_allocator alloc;
+         db::array a;
+         for(size_t i(0); i < ARRAY_MIN_ORDER - 1; ++i) {
+            vm::tuple *tpl(a.expand(f, &alloc));
+            tpl->set_int(0, (vm::int_val)i);
+            tpl->set_int(1, (vm::int_val)i);
+         }
+         // too small to be worth sorting.
+         a.freeze(f);
+         CPPUNIT_ASSERT(!a.has_order());
+
+         vm::candidate_gc_nodes gc_nodes;
+         a.wipeout(f, &alloc, gc_nodes);
+      }
+
+      CPPUNIT_TEST_SUITE(DbArrayTests);
+
+      CPPUNIT_TEST(testFreeze);
+      CPPUNIT_TEST(testGaps);
+      CPPUNIT_TEST(testSmall);
+      CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DbArrayTests);
@@ -0,0 +1,103 @@
+
+#ifndef DB_COLUMN_FILTER_HPP
+#define DB_COLUMN_FILTER_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "vm/defs.hpp"
+
+namespace db {
+
+// Equality filters over a column of at most 64 fields.
+// Bit i of the result is set if the i-th field is equal to the value.
+// AVX2 and SSE2 versions are used when the compiler targets them
+// (build with ARCH="-march=native" to get AVX2).
+
+static_assert(sizeof(vm::tuple_field) == sizeof(uint64_t),
+              "column filters assume 64 bit fields.");
+
+// int fields only use the low 32 bits of the field.
+inline uint64_t column_filter_int(const vm::tuple_field *col, const size_t n,
+                                  const vm::int_val val) {
+   uint64_t mask(0);
+   size_t i(0);
+#if defined(__AVX2__)
+   const __m256i v(_mm256_set1_epi32(val));
+   for (; i + 4 <= n; i += 4) {
+      const __m256i x(_mm256_loadu_si256((const __m256i *)(col + i)));
+      const int bits(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(x, v))));
+      // keep the low half of each field.
+      const int low((bits & 1) | ((bits >> 1) & 2) | ((bits >> 2) & 4) |
+                    ((bits >> 3) & 8));
+      mask |= (uint64_t)low << i;
+   }
+#elif defined(__SSE2__)
+   const __m128i v(_mm_set1_epi32(val));
+   for (; i + 2 <= n; i += 2) {
+      const __m128i x(_mm_loadu_si128((const __m128i *)(col + i)));
+      const int bits(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(x, v))));
+      mask |= (uint64_t)((bits & 1) | ((bits >> 1) & 2)) << i;
+   }
+#endif
+   for (; i < n; ++i)
+      if (FIELD_INT(col[i]) == val) mask |= (uint64_t)1 << i;
+   return mask;
+}
+
+inline uint64_t column_filter_float(const vm::tuple_field *col, const size_t n,
+                                    const vm::float_val val) {
+   uint64_t mask(0);
+   size_t i(0);
+#if defined(__AVX2__)
+   const __m256d v(_mm256_set1_pd(val));
+   for (; i + 4 <= n; i += 4) {
+      const __m256d x(_mm256_loadu_pd((const double *)(col + i)));
+      mask |= (uint64_t)_mm256_movemask_pd(_mm256_cmp_pd(x, v, _CMP_EQ_OQ)) << i;
+   }
+#elif defined(__SSE2__)
+   const __m128d v(_mm_set1_pd(val));
+   for (; i + 2 <= n; i += 2) {
+      const __m128d x(_mm_loadu_pd((const double *)(col + i)));
+      mask |= (uint64_t)_mm_movemask_pd(_mm_cmpeq_pd(x, v)) << i;
+   }
+#endif
+   for (; i < n; ++i)
+      if (FIELD_FLOAT(col[i]) == val) mask |= (uint64_t)1 << i;
+   return mask;
+}
+
+inline uint64_t column_filter_node(const vm::tuple_field *col, const size_t n,
+                                   const vm::node_val val) {
+   uint64_t mask(0);
+   size_t i(0);
+#if defined(__AVX2__)
+   const __m256i v(_mm256_set1_epi64x(val));
+   for (; i + 4 <= n; i += 4) {
+      const __m256i x(_mm256_loadu_si256((const __m256i *)(col + i)));
+      mask |= (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(x, v))) << i;
+   }
+#elif defined(__SSE2__)
+   const __m128i v(_mm_set1_epi64x(val));
+   for (; i + 2 <= n; i += 2) {
+      const __m128i x(_mm_loadu_si128((const __m128i *)(col + i)));
+      // SSE2 has no 64 bit compare: both halves must be equal.
+      const __m128i eq(_mm_cmpeq_epi32(x, v));
+      const __m128i both(_mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1))));
+      mask |= (uint64_t)_mm_movemask_pd(_mm_castsi128_pd(both)) << i;
+   }
+#endif
+   for (; i < n; ++i)
+      if (FIELD_NODE(col[i]) == val) mask |= (uint64_t)1 << i;
+   return mask;
+}
+
+}
+
+#endif
@@ -0,0 +1,218 @@
+#ifndef DB_COLUMN_STORE_HPP
+#define DB_COLUMN_STORE_HPP
+
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+#include "vm/predicate.hpp"
+#include "vm/tuple.hpp"
+#include "vm/defs.hpp"
+#include "vm/match.hpp"
+#include "mem/node.hpp"
+#include "db/column_filter.hpp"
+
+namespace db {
+
+// Columnar storage for linear predicates with only int, float or node fields.
+// Each field is stored in a contiguous column next to a column with the
+// tuple objects and a bitmap of used rows, so that tuples can be filtered
+// by scanning the columns instead of following the pointers of a list.
+// New tuples are appended at the end, therefore rows are kept in insertion order.
+// Removed tuples leave holes that are only removed by compact(), since rows
+// must not move while the node is running.
+// Tuples in the store keep their row in the intrusive prev pointer.
+struct column_store {
+   utils::byte *data{nullptr};
+   uint32_t cap{0};
+   // rows in use, including holes.
+   uint32_t high{0};
+   uint32_t total{0};
+
+#define COLUMN_STORE_INITIAL_SIZE 8
+#define COLUMN_STORE_BITS 64
+
+   private:
+
+   static inline size_t num_words(const size_t _cap) { return (_cap + COLUMN_STORE_BITS - 1) / COLUMN_STORE_BITS; }
+
+   static inline size_t compute_size(const vm::predicate *pred, const size_t _cap) {
+      return _cap * sizeof(vm::tuple*) + pred->num_fields() * _cap * sizeof(vm::tuple_field) +
+         num_words(_cap) * sizeof(uint64_t);
+   }
+
+   inline vm::tuple **rows() const { return (vm::tuple**)data; }
+   inline vm::tuple_field *columns() const { return (vm::tuple_field*)(data + cap * sizeof(vm::tuple*)); }
+   inline uint64_t *used(const vm::predicate *pred) const {
+      return (uint64_t*)(data + cap * sizeof(vm::tuple*) + pred->num_fields() * cap * sizeof(vm::tuple_field));
+   }
+
+   static inline size_t get_row(const vm::tuple *tpl) { return (size_t)(std::uintptr_t)tpl->__intrusive_prev; }
+   static inline void set_row(vm::tuple *tpl, const size_t row) {
+      tpl->__intrusive_prev = (void*)(std::uintptr_t)row;
+      tpl->__intrusive_next = nullptr;
+   }
+
+   inline void write_row(const size_t row, const vm::tuple *tpl, const vm::predicate *pred) {
+      vm::tuple_field *cols(columns());
+      for(size_t i(0); i < pred->num_fields(); ++i)
+         cols[i * cap + row] = tpl->get_field(i);
+   }
+
+   inline void resize(const size_t new_cap, const vm::predicate *pred, mem::node_allocator *alloc) {
+      utils::byte *old(data);
+      const size_t old_cap(cap);
+      const size_t old_high(high);
+      vm::tuple **old_rows(rows());
+      vm::tuple_field *old_cols(columns());
+      uint64_t *old_used(old ? used(pred) : nullptr);
+
+      data = alloc->allocate_obj(compute_size(pred, new_cap));
+      cap = new_cap;
+      memset(used(pred), 0, num_words(new_cap) * sizeof(uint64_t));
+      if(old) {
+         memcpy(rows(), old_rows, old_high * sizeof(vm::tuple*));
+         for(size_t i(0); i < pred->num_fields(); ++i)
+            memcpy(columns() + i * cap, old_cols + i * old_cap, old_high * sizeof(vm::tuple_field));
+         memcpy(used(pred), old_used, num_words(old_high) * sizeof(uint64_t));
+         alloc->deallocate_obj(old, compute_size(pred, old_cap));
+      }
+   }
+
+   public:
+
+   inline size_t size() const { return total; }
+   inline bool empty() const { return total == 0; }
+   inline size_t end_row() const { return high; }
+
+   inline bool is_used(const size_t row, const vm::predicate *pred) const {
+      return used(pred)[row / COLUMN_STORE_BITS] & ((uint64_t)1 << (row % COLUMN_STORE_BITS));
+   }
+
+   // returns the next used row starting from 'row' or end_row().
+   inline size_t next_row(size_t row, const vm::predicate *pred) const {
+      const uint64_t *bits(used(pred));
+      while(row < high) {
+         const uint64_t word(bits[row / COLUMN_STORE_BITS] >> (row % COLUMN_STORE_BITS));
+         if(word)
+            return row + __builtin_ctzll(word);
+         row = (row / COLUMN_STORE_BITS + 1) * COLUMN_STORE_BITS;
+      }
+      return high;
+   }
+
+   // returns the used rows of the block starting at 'block' that are not in
+   // 'seen' and match 'm'. 'seen' is updated with the used rows of the block,
+   // so that calling it again only returns rows added in the meantime.
+   inline uint64_t match_block(const size_t block, const vm::match *m,
+         const vm::predicate *pred, uint64_t& seen) const {
+      assert(block % COLUMN_STORE_BITS == 0);
+      const uint64_t in_use(used(pred)[block / COLUMN_STORE_BITS]);
+      uint64_t mask(in_use & ~seen);
+      seen = in_use;
+      if(!mask || !m || !m->any_exact)
+         return mask;
+      const size_t n(std::min((size_t)COLUMN_STORE_BITS, high - block));
+      for(size_t i(0); i < pred->num_fields() && mask; ++i) {
+         if(!m->has_match(i))
+            continue;
+         const vm::tuple_field *col(columns() + i * cap + block);
+         const vm::tuple_field val(m->get_match(i).field);
+         switch(pred->get_field_type(i)->get_type()) {
+            case vm::FIELD_INT: mask &= column_filter_int(col, n, FIELD_INT(val)); break;
+            case vm::FIELD_FLOAT: mask &= column_filter_float(col, n, FIELD_FLOAT(val)); break;
+            case vm::FIELD_NODE: mask &= column_filter_node(col, n, FIELD_NODE(val)); break;
+            default: assert(false); break;
+         }
+      }
+      return mask;
+   }
+
+   inline vm::tuple *get_tuple(const size_t row) const { return rows()[row]; }
+   inline vm::tuple_field get_field(const size_t row, const vm::field_num field) const {
+      return columns()[field * cap + row];
+   }
+
+   inline void add(vm::tuple *tpl, const vm::predicate *pred, mem::node_allocator *alloc) {
+      if(high == cap)
+         resize(cap == 0 ? COLUMN_STORE_INITIAL_SIZE : cap * 2, pred, alloc);
+      const size_t row(high++);
+      rows()[row] = tpl;
+      write_row(row, tpl, pred);
+      used(pred)[row / COLUMN_STORE_BITS] |= (uint64_t)1 << (row % COLUMN_STORE_BITS);
+      set_row(tpl, row);
+      total++;
+   }
+
+   inline void add_list(vm::tuple_list& ls, const vm::predicate *pred, mem::node_allocator *alloc) {
+      for(auto it(ls.begin()), end(ls.end()); it != end; ) {
+         vm::tuple *tpl(*it);
+         ++it;
+         add(tpl, pred, alloc);
+      }
+      ls.clear();
+   }
+
+   inline void remove(vm::tuple *tpl, const vm::predicate *pred) {
+      const size_t row(get_row(tpl));
+      assert(row < high && rows()[row] == tpl);
+      used(pred)[row / COLUMN_STORE_BITS] &= ~((uint64_t)1 << (row % COLUMN_STORE_BITS));
+      rows()[row] = nullptr;
+      total--;
+   }
+
+   // the fields of a tuple in the store were changed.
+   inline void update(const vm::tuple *tpl, const vm::predicate *pred) {
+      write_row(get_row(tpl), tpl, pred);
+   }
+
+   template <typename F>
+   inline void for_each(const vm::predicate *pred, F f) const {
+      for(size_t row(next_row(0, pred)); row < high; row = next_row(row + 1, pred))
+         f(get_tuple(row));
+   }
+
+   // removes the holes left by removed tuples. must not be called while iterating.
+   inline void compact(const vm::predicate *pred) {
+      if(total == high)
+         return;
+      if(total > 0 && high - total < total)
+         return;
+      vm::tuple **r(rows());
+      vm::tuple_field *cols(columns());
+      uint64_t *bits(used(pred));
+      size_t to(0);
+      for(size_t row(next_row(0, pred)); row < high; row = next_row(row + 1, pred)) {
+         if(to != row) {
+            r[to] = r[row];
+            for(size_t i(0); i < pred->num_fields(); ++i)
+               cols[i * cap + to] = cols[i * cap + row];
+            set_row(r[to], to);
+         }
+         to++;
+      }
+      assert(to == total);
+      memset(bits, 0, num_words(cap) * sizeof(uint64_t));
+      for(size_t i(0); i < total / COLUMN_STORE_BITS; ++i)
+         bits[i] = ~(uint64_t)0;
+      if(total % COLUMN_STORE_BITS)
+         bits[total / COLUMN_STORE_BITS] = ((uint64_t)1 << (total % COLUMN_STORE_BITS)) - 1;
+      high = total;
+   }
+
+   inline void destroy(const vm::predicate *pred, mem::node_allocator *alloc,
+         vm::candidate_gc_nodes& gc_nodes, const bool fast) {
+      if(!fast) {
+         for(size_t row(next_row(0, pred)); row < high; row = next_row(row + 1, pred))
+            vm::tuple::destroy(get_tuple(row), pred, alloc, gc_nodes);
+      }
+      if(data)
+         alloc->deallocate_obj(data, compute_size(pred, cap));
+      data = nullptr;
+      cap = high = total = 0;
+   }
+};
+
+}
+
+#endif
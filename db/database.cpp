@@ -1,4 +1,7 @@
 
+#include <cstring>
+#include <vector>
+
 #include "vm/defs.hpp"
 #include "db/database.hpp"
 #include "vm/state.hpp"
@@ -15,48 +18,73 @@ namespace db
 database::database(istream& fp)
 {
    int_val num_nodes;
-   node::node_id fake_id;
-   node::node_id user_id;
    
    fp.read((char*)&num_nodes, sizeof(int_val));
-   
+
+   // read the whole table at once.
+   vector<node::node_id> table(2 * (size_t)num_nodes);
+   fp.read((char*)table.data(), table.size() * sizeof(node::node_id));
+
+   load_nodes(table.data(), (size_t)num_nodes);
+}
+
+database::database(const utils::byte *data)
+{
+   int_val num_nodes;
+
+   memcpy(&num_nodes, data, sizeof(int_val));
+
+   // the table is not aligned in the mapped file.
+   vector<node::node_id> table(2 * (size_t)num_nodes);
+   memcpy(table.data(), data + sizeof(int_val), table.size() * sizeof(node::node_id));
+
+   load_nodes(table.data(), (size_t)num_nodes);
+}
+
+void
+database::load_nodes(const node::node_id *table, const size_t num_nodes)
+{
+   // table has pairs of (fake id, user id).
    nodes_total = num_nodes;
    
-   max_node_id = -1;
-   max_translated_id = -1;
+   node::node_id max_fake((node::node_id)-1);
+   node::node_id max_user((node::node_id)-1);
       
    for(size_t i(0); i < nodes_total; ++i) {
-      fp.read((char*)&fake_id, sizeof(node::node_id));
-      fp.read((char*)&user_id, sizeof(node::node_id));
-      
-      // nodes themselves are created by each thread in sched/init_node.
-      nodes[fake_id] = (db::node*)user_id;
+      const node::node_id fake_id(table[2 * i]);
+      const node::node_id user_id(table[2 * i + 1]);
 
-      if(fake_id > max_node_id || max_node_id == (db::node::node_id)-1)
-         max_node_id = fake_id;
-      if(user_id > max_translated_id || max_translated_id == (db::node::node_id)-1)
-         max_translated_id = user_id;
+      if(fake_id >= node_directory::MAX_NODES)
+         throw database_error("node id is too large");
+      
+      if(fake_id >= initial_translations.size())
+         initial_translations.resize(fake_id + 1, (node::node_id)-1);
+      initial_translations[fake_id] = user_id;
+
+      if(fake_id > max_fake || max_fake == (db::node::node_id)-1)
+         max_fake = fake_id;
+      if(user_id > max_user || max_user == (db::node::node_id)-1)
+         max_user = user_id;
    }
    
-   original_max_node_id = max_node_id;
+   max_node_id = max_fake;
+   max_translated_id = max_user;
+   original_max_node_id = max_fake;
 }
 
 void
 database::wipeout(candidate_gc_nodes& gc_nodes)
 {
    deleting = true;
-   for(auto & elem : nodes) {
-      db::node *n(elem.second);
+   nodes.for_each([&gc_nodes](const node::node_id, db::node *n) {
       n->wipeout(gc_nodes);
       n->deallocate();
-   }
+   });
 }
 
 node*
 database::create_node_id(const db::node::node_id id)
 {
-   MUTEX_LOCK_GUARD(mtx, main_db_lock);
-
    if(max_node_id > 0) {
       assert(max_node_id < id);
       assert(max_translated_id < id);
@@ -65,33 +93,34 @@ database::create_node_id(const db::node::node_id id)
    max_node_id = id;
    max_translated_id = id;
 
-   node *ret(node::create(max_node_id, max_translated_id));
+   node *ret(node::create(id, id));
 
-   nodes[max_node_id] = ret;
+   add_node(ret);
    nodes_total++;
 
    return ret;
 }
 
 node*
-database::create_node_iterator(database::map_nodes::iterator it)
+database::create_initial_node(const node::node_id id)
 {
-   it->second = node::create(it->first, (node::node_id)it->second);
-   return it->second;
+   if(id >= initial_translations.size() ||
+         initial_translations[id] == (node::node_id)-1)
+      return nullptr;
+
+   node *ret(node::create(id, initial_translations[id]));
+   add_node(ret);
+   return ret;
 }
 
 pair<node::node_id, node::node_id>
 database::allocate_ids(const size_t size)
 {
-   MUTEX_LOCK_GUARD(mtx, main_db_lock);
-
-   pair<node::node_id, node::node_id> ret(
-         make_pair(max_node_id + 1, max_translated_id + 1));
+   // each counter hands out disjoint ranges, so threads never need a lock here.
+   const node::node_id first(max_node_id.fetch_add(size) + 1);
+   const node::node_id first_translated(max_translated_id.fetch_add(size) + 1);
 
-   max_node_id += size;
-   max_translated_id += size;
-
-   return ret;
+   return make_pair(first, first_translated);
 }
 
 static bool
@@ -104,23 +133,21 @@ size_t
 database::total_facts(void) const
 {
    size_t total(0);
-   for(const auto & elem : nodes) {
-      db::node *n(elem.second);
+   nodes.for_each([&total](const node::node_id, db::node *n) {
       total += n->count_total_all();
-   }
+   });
    return total;
 }
 
 void
 database::print_db(ostream& cout) const
 {
-   std::vector<db::node*> arr(num_nodes(), nullptr);
+   std::vector<db::node*> arr;
 
-   size_t i(0);
-   for(const auto & elem : nodes)
-   {
-      arr[i++] = elem.second;
-   }
+   arr.reserve(nodes.size());
+   nodes.for_each([&arr](const node::node_id, db::node *n) {
+      arr.push_back(n);
+   });
 
    sort(arr.begin(), arr.end(), node_sorter);
    for(auto & elem : arr) {
@@ -131,24 +158,23 @@ database::print_db(ostream& cout) const
 void
 database::dump_db(ostream& cout) const
 {
-   for(const auto & elem : nodes)
-   {
-      elem.second->dump(cout);
-   }
+   nodes.for_each([&cout](const node::node_id, db::node *n) {
+      n->dump(cout);
+   });
 }
 
 void
 database::print(ostream& cout) const
 {
+   bool first(true);
+
    cout << "{";
-   for(auto it(nodes.begin());
-      it != nodes.end();
-      ++it)
-   {
-      if(it != nodes.begin())
+   nodes.for_each([&cout, &first](const node::node_id id, db::node *) {
+      if(!first)
          cout << ", ";
-      cout << it->first;
-   }
+      first = false;
+      cout << id;
+   });
    cout << "}";
 }
 
@@ -2,14 +2,16 @@
 #ifndef DATABASE_HPP
 #define DATABASE_HPP
 
-#include <map>
+#include <algorithm>
+#include <atomic>
 #include <functional>
 #include <fstream>
 #include <ostream>
-#include <unordered_map>
+#include <vector>
 #include <stdexcept>
 
 #include "db/node.hpp"
+#include "db/node_directory.hpp"
 #include "vm/program.hpp"
 #include "utils/mutex.hpp"
 
@@ -18,21 +20,18 @@ namespace db
 
 class database
 {
-public:
-   
-   using map_nodes = 
-      std::map<node::node_id, node*,
-         std::less<node::node_id>,
-         mem::allocator< std::pair<const node::node_id, node*>>>;
-
 private:
 
-   map_nodes nodes;
+   node_directory nodes;
+   // translated ids of the initial nodes, indexed by node id.
+   // nodes themselves are created by each thread in sched/init_node.
+   std::vector<node::node_id> initial_translations;
    node::node_id original_max_node_id;
-   node::node_id max_node_id;
-   node::node_id max_translated_id;
+   std::atomic<node::node_id> max_node_id;
+   std::atomic<node::node_id> max_translated_id;
+
+   void load_nodes(const node::node_id *, const size_t);
 
-   utils::mutex mtx;
    // marks the database object as being deleted
    // needed because tuples may need to reference other nodes that were already deleted.
    bool deleting = false;
@@ -45,11 +44,8 @@ public:
    static const size_t node_size = sizeof(node::node_id) * 2;
    size_t nodes_total{0};
    
-   map_nodes::const_iterator nodes_begin(void) const { return nodes.begin(); }
-   map_nodes::const_iterator nodes_end(void) const { return nodes.end(); }
-   map_nodes::iterator get_node_iterator(const node::node_id id) { return nodes.find(id); }
-   
-   size_t num_nodes(void) const { return nodes.size(); }
+   // before the initial nodes are created, count them from the node table.
+   size_t num_nodes(void) const { return std::max(nodes.size(), nodes_total); }
    node::node_id max_id(void) const { return max_node_id; }
    node::node_id static_max_id(void) const { return original_max_node_id; }
    inline bool is_deleting(void) const { return deleting; }
@@ -60,26 +56,26 @@ public:
       return n->get_id() <= original_max_node_id;
    }
    
-   void add_node_set(map_nodes& m)
+   // ids must come from allocate_ids, so no two threads add the same node.
+   inline void add_node(node *n)
    {
-      MUTEX_LOCK_GUARD(mtx, main_db_lock);
-      for(auto& p : m)
-         nodes[p.first] = p.second;
+      nodes.set(n->get_id(), n);
    }
 
    node* find_node(const node::node_id id) const
    {
-      auto it(nodes.find(id));
+      node *n(nodes.get(id));
 
-      if(it == nodes.end())
+      if(n == nullptr)
          abort();
       
-      return it->second;
+      return n;
    }
 
    std::pair<node::node_id, node::node_id> allocate_ids(const size_t);
    node* create_node_id(const node::node_id);
-   node* create_node_iterator(map_nodes::iterator);
+   // creates the initial node with the given id or returns NULL if the id is not in the node table.
+   node* create_initial_node(const node::node_id);
    
    size_t total_facts(void) const;
    void print_db(std::ostream&) const;
@@ -88,6 +84,8 @@ public:
    void print(std::ostream&) const;
    
    explicit database(std::istream&);
+   // reads the node table directly from memory (e.g., a mapped file).
+   explicit database(const utils::byte *);
    
    void wipeout(vm::candidate_gc_nodes&);
 
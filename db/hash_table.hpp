@@ -23,6 +23,10 @@ static_assert(HASH_TABLE_PRIME < HASH_TABLE_INITIAL_TABLE_SIZE, "prime < size");
 static_assert(sizeof(BITMAP_TYPE) * 8 >= HASH_TABLE_INITIAL_TABLE_SIZE, "wrong table size");
 
 #define CREATE_HASHTABLE_THREADSHOLD 8
+// a hash table goes back to a list once it has fewer facts than this
+// for HASH_TABLE_SHRINK_CHECKS consecutive index cleanups.
+#define HASH_TABLE_SHRINK_THRESHOLD (CREATE_HASHTABLE_THREADSHOLD / 2)
+#define HASH_TABLE_SHRINK_CHECKS 2
 #define HASH_TABLE_MAX_LEVELS 4
 #define HASH_TABLE_SUBHASH_MASK ((1 << HASH_TABLE_SUBHASH_SHIFT) - 1)
 
@@ -305,6 +309,8 @@ public:
    inline void setup(subhash_table *par)
    {
       memset(table, 0, sizeof(tuple_list*) * HASH_TABLE_INITIAL_TABLE_SIZE);
+      // memory may come from a recycled object of the node arena.
+      bitmap.clear();
       parent = par;
       unique_lists = 0;
       unique_subs = 0;
@@ -336,6 +342,8 @@ struct hash_table {
    subhash_table *sh;
    size_t elems{0};
    vm::field_type hash_type;
+   // consecutive calls to too_sparse() that found the table small.
+   std::uint16_t sparse_checks{0};
 
    public:
 
@@ -451,9 +459,16 @@ reset:
       sh->dump(out, pred);
    }
 
-   inline bool too_sparse() const
+   // the table is only turned into a list after being small for a while,
+   // so that nodes whose fact count goes up and down around
+   // CREATE_HASHTABLE_THREADSHOLD do not keep rebuilding it.
+   inline bool too_sparse()
    {
-      return sh->unique_lists < CREATE_HASHTABLE_THREADSHOLD/2 && sh->unique_subs == 0;
+      if(elems >= HASH_TABLE_SHRINK_THRESHOLD || sh->unique_subs > 0) {
+         sparse_checks = 0;
+         return false;
+      }
+      return ++sparse_checks >= HASH_TABLE_SHRINK_CHECKS;
    }
 
    static inline vm::tuple_list *underlying_list(tuple_list *ls)
@@ -477,6 +492,7 @@ reset:
    {
       hash_type = type;
       elems = 0;
+      sparse_checks = 0;
       sh = (subhash_table*)alloc->allocate_obj(sizeof(subhash_table));
       sh->setup(nullptr);
    }
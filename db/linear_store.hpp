@@ -15,11 +15,15 @@
 #include "vm/bitmap_static.hpp"
 #include "utils/intrusive_list.hpp"
 #include "db/hash_table.hpp"
+#include "db/column_store.hpp"
 #include "mem/node.hpp"
 
-#define ITEM_SIZE                                                 \
+#define ITEM_SIZE_LIST                                            \
    ((sizeof(hash_table) > sizeof(tuple_list) ? sizeof(hash_table) \
                                              : sizeof(tuple_list)))
+#define ITEM_SIZE                                                       \
+   ((ITEM_SIZE_LIST > sizeof(column_store) ? ITEM_SIZE_LIST \
+                                           : sizeof(column_store)))
 
 namespace db {
 
@@ -27,8 +31,8 @@ struct linear_store {
    public:
    using tuple_list = vm::tuple_list;
 
-// we store N lists or hash tables (the biggest structure) so that it is
-// contiguous
+// we store N lists, hash tables or column stores (the biggest structure) so
+// that it is contiguous
 #ifdef COMPILED
    utils::byte data[ITEM_SIZE * COMPILED_NUM_LINEAR];
    vm::bitmap_static<COMPILED_NUM_LINEAR_UINT> types;
@@ -57,6 +61,11 @@ struct linear_store {
       return table;
    }
 
+   inline column_store *get_columns(const vm::predicate_id p) const {
+      assert(p < vm::theProgram->num_linear_predicates());
+      return (column_store *)(data + ITEM_SIZE * p);
+   }
+
    inline tuple_list *get_list(const vm::predicate_id p) {
       assert(p < vm::theProgram->num_linear_predicates());
       return (tuple_list *)(data + ITEM_SIZE * p);
@@ -103,6 +112,9 @@ struct linear_store {
       }
 
       types.set_bit(pred->get_linear_id());
+#ifdef FACT_STATISTICS
+      pred->stat_to_hash_table++;
+#endif
 
       return tbl;
    }
@@ -127,6 +139,9 @@ struct linear_store {
       memcpy(tbl, &ls, sizeof(tuple_list));
 
       types.unset_bit(pred->get_linear_id());
+#ifdef FACT_STATISTICS
+      pred->stat_to_list++;
+#endif
 
       return (tuple_list *)tbl;
    }
@@ -134,6 +149,8 @@ struct linear_store {
    public:
    inline bool empty(const vm::predicate_id id) const {
       if (stored_as_hash_table_id(id)) return get_table(id)->empty();
+      if (vm::theProgram->get_linear_predicate(id)->is_columnar())
+         return get_columns(id)->empty();
       return get_list(id)->empty();
    }
 
@@ -151,6 +168,17 @@ struct linear_store {
       return get_table(p);
    }
 
+   inline column_store *get_column_store(const vm::predicate_id p) {
+      return get_columns(p);
+   }
+   inline const column_store *get_column_store(const vm::predicate_id p) const {
+      return get_columns(p);
+   }
+
+   inline bool stored_as_columns(const vm::predicate *pred) const {
+      return pred->is_columnar();
+   }
+
    inline bool stored_as_hash_table_id(const vm::predicate_id id) const {
       return types.get_bit(id);
    }
@@ -165,6 +193,10 @@ struct linear_store {
 
    inline void add_fact_list(vm::tuple_list &ls, const vm::predicate *pred, mem::node_allocator *alloc)
        __attribute__((always_inline)) {
+      if (stored_as_columns(pred)) {
+         get_columns(pred->get_linear_id())->add_list(ls, pred, alloc);
+         return;
+      }
       if (pred->is_hash_table()) {
          if (stored_as_hash_table(pred)) {
             hash_table *table(get_table(pred->get_linear_id()));
@@ -205,6 +237,10 @@ struct linear_store {
 
    inline void add_fact(vm::tuple *tpl, vm::predicate *pred, mem::node_allocator *alloc)
        __attribute__((always_inline)) {
+      if (stored_as_columns(pred)) {
+         get_columns(pred->get_linear_id())->add(tpl, pred, alloc);
+         return;
+      }
       if (pred->is_hash_table()) {
          if (stored_as_hash_table(pred)) {
             hash_table *table(get_table(pred->get_linear_id()));
@@ -229,6 +265,10 @@ struct linear_store {
    }
 
    inline void increment_database(vm::predicate *pred, tuple_list *ls, mem::node_allocator *alloc) {
+      if (stored_as_columns(pred)) {
+         get_columns(pred->get_linear_id())->add_list(*ls, pred, alloc);
+         return;
+      }
       if (pred->is_hash_table()) {
          if (stored_as_hash_table(pred)) {
             hash_table *table(get_table(pred->get_linear_id()));
@@ -286,6 +326,10 @@ struct linear_store {
    }
 
    inline void cleanup_index(mem::node_allocator *alloc) {
+#ifdef COLUMNAR_STORE
+      for (const vm::predicate *pred : vm::theProgram->columnar_predicates)
+         get_columns(pred->get_linear_id())->compact(pred);
+#endif
       for (auto it(types.begin(vm::theProgram->num_linear_predicates()));
            !it.end(); ++it) {
          const vm::predicate_id id(*it);
@@ -344,15 +388,21 @@ struct linear_store {
                vm::theProgram->num_linear_predicates_next_uint());
       }
 #endif
-      for (size_t i(0); i < vm::theProgram->num_linear_predicates(); ++i)
-         mem::allocator<tuple_list>().construct(get_list(i));
+      for (size_t i(0); i < vm::theProgram->num_linear_predicates(); ++i) {
+         if (vm::theProgram->get_linear_predicate(i)->is_columnar())
+            mem::allocator<column_store>().construct(get_columns(i));
+         else
+            mem::allocator<tuple_list>().construct(get_list(i));
+      }
    }
 
    inline void destroy(mem::node_allocator *alloc,
                        vm::candidate_gc_nodes &gc_nodes, const bool fast = false) {
       for (size_t i(0); i < vm::theProgram->num_linear_predicates(); ++i) {
          vm::predicate *pred(vm::theProgram->get_linear_predicate(i));
-         if (types.get_bit(i)) {
+         if (pred->is_columnar())
+            get_columns(i)->destroy(pred, alloc, gc_nodes, fast);
+         else if (types.get_bit(i)) {
             hash_table *table(get_table(i));
             if (!fast) {
                for (hash_table::iterator it(table->begin()); !it.end(); ++it) {
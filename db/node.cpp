@@ -20,6 +20,8 @@ size_t node::count_total(const predicate *pred) const {
       const hash_table *table(linear.get_hash_table(pred->get_linear_id()));
       return table->get_total_size();
    }
+   if (linear.stored_as_columns(pred))
+      return linear.get_column_store(pred->get_linear_id())->size();
 
    const intrusive_list<vm::tuple> *ls(
        linear.get_linked_list(pred->get_linear_id()));
@@ -58,6 +60,9 @@ void node::dump(ostream &cout) const {
                      vec.push_back((*it)->to_str(pred));
                }
             }
+         } else if (linear.stored_as_columns(pred)) {
+            linear.get_column_store(pred->get_linear_id())->for_each(pred,
+                  [&vec, pred](vm::tuple *tpl) { vec.push_back(tpl->to_str(pred)); });
          } else {
             const intrusive_list<vm::tuple> *ls(
                 linear.get_linked_list(pred->get_linear_id()));
@@ -102,6 +107,9 @@ void node::print(ostream &cout) const {
                      vec.push_back((*it)->to_str(pred));
                }
             }
+         } else if (linear.stored_as_columns(pred)) {
+            linear.get_column_store(pred->get_linear_id())->for_each(pred,
+                  [&vec, pred](vm::tuple *tpl) { vec.push_back(tpl->to_str(pred)); });
          } else {
             const intrusive_list<vm::tuple> *ls(
                 linear.get_linked_list(pred->get_linear_id()));
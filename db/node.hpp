@@ -33,6 +33,9 @@ class thread;
 
 namespace db {
 
+// number of executions of a node between index cleanups.
+#define INDEX_CLEANUP_ROUNDS 4
+
 struct node {
    public:
    std::atomic<vm::ref_count> refs{0};
@@ -70,7 +73,8 @@ struct node {
    size_t count_total(const vm::predicate *) const;
    size_t count_total_all(void) const;
    inline bool garbage_collect(void) const {
-      return refs == 0 && matcher.is_empty() && !unprocessed_facts;
+      return refs == 0 && matcher.is_empty() && !unprocessed_facts &&
+             store.inbox.empty();
    }
 
    inline bool try_garbage_collect() {
@@ -132,6 +136,13 @@ struct node {
    // marker that indicates if the node should not be stolen.
    // when not nullptr it indicates which scheduler it needs to be on.
    sched::thread *static_node = nullptr;
+   // where the facts sent by the node go: majority vote over the
+   // destination threads of the last 'comm_samples' sends.
+   sched::thread *comm_candidate{nullptr};
+   uint16_t comm_votes{0};
+   uint16_t comm_samples{0};
+   // placed by set-cpu or set-affinity, so it is never migrated.
+   std::atomic<bool> placed{false};
    utils::mutex main_lock;
    utils::mutex database_lock;
 
@@ -210,6 +221,18 @@ struct node {
       }
    }
 
+   // moves the batches sent by other threads into the database.
+   // both the main and database locks must be held.
+   inline void process_inbox() {
+      vm::buffer_batch *batch(store.inbox.pop_all());
+      while (batch) {
+         vm::buffer_batch *next(batch->next);
+         add_work_myself(batch->b);
+         vm::buffer_batch::destroy(batch);
+         batch = next;
+      }
+   }
+
    inline void add_work_myself(vm::full_tuple_list &ls) {
       unprocessed_facts = true;
       for (auto it(ls.begin()), end(ls.end()); it != end;) {
@@ -282,7 +305,7 @@ struct node {
    inline void manage_index() {
       linear.improve_index();
       rounds++;
-      if (rounds > 0 && rounds % 1 == 0) linear.cleanup_index(&alloc);
+      if (rounds % INDEX_CLEANUP_ROUNDS == 0) linear.cleanup_index(&alloc);
    }
 
    inline explicit node(const node_id _id, const node_id _trans)
@@ -293,6 +316,8 @@ struct node {
 
    inline void wipeout(vm::candidate_gc_nodes &gc_nodes,
                        const bool fast = false) {
+      // the arena goes away with the node, so freed tuples are not recycled.
+      alloc.release_all();
       linear.destroy(&alloc, gc_nodes, fast);
       pers_store.wipeout(&alloc, gc_nodes);
 
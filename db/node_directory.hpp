@@ -0,0 +1,126 @@
+
+#ifndef DB_NODE_DIRECTORY_HPP
+#define DB_NODE_DIRECTORY_HPP
+
+#include <atomic>
+#include <stdexcept>
+
+#include "db/node.hpp"
+
+namespace db
+{
+
+// dense table of nodes indexed by node id.
+// the table is split into chunks that are allocated on demand,
+// so threads can insert nodes into their own id ranges concurrently
+// without locking and lookups are always two loads.
+class node_directory
+{
+   private:
+
+      static const size_t CHUNK_BITS = 14;
+      static const size_t CHUNK_SIZE = 1 << CHUNK_BITS;
+      static const size_t CHUNK_MASK = CHUNK_SIZE - 1;
+      static const size_t MAX_CHUNKS = 1 << 16;
+
+      using slot = std::atomic<node*>;
+
+      std::atomic<slot*> *chunks;
+      // one past the highest id ever stored.
+      std::atomic<node::node_id> limit{0};
+      std::atomic<size_t> count{0};
+
+      inline slot *get_chunk(const size_t c) const
+      {
+         return chunks[c].load(std::memory_order_acquire);
+      }
+
+      slot *ensure_chunk(const size_t c)
+      {
+         slot *chunk(get_chunk(c));
+         if(chunk)
+            return chunk;
+
+         slot *fresh(new slot[CHUNK_SIZE]);
+         for(size_t i(0); i < CHUNK_SIZE; ++i)
+            fresh[i].store(nullptr, std::memory_order_relaxed);
+
+         if(chunks[c].compare_exchange_strong(chunk, fresh,
+                  std::memory_order_acq_rel, std::memory_order_acquire))
+            return fresh;
+         // some other thread installed the chunk first.
+         delete []fresh;
+         return chunk;
+      }
+
+   public:
+
+      static const node::node_id MAX_NODES = MAX_CHUNKS * CHUNK_SIZE;
+
+      inline size_t size(void) const { return count.load(std::memory_order_relaxed); }
+      inline node::node_id end_id(void) const { return limit.load(std::memory_order_acquire); }
+
+      inline node *get(const node::node_id id) const
+      {
+         if(id >= MAX_NODES)
+            return nullptr;
+         slot *chunk(get_chunk(id >> CHUNK_BITS));
+         if(chunk == nullptr)
+            return nullptr;
+         return chunk[id & CHUNK_MASK].load(std::memory_order_acquire);
+      }
+
+      void set(const node::node_id id, node *n)
+      {
+         if(id >= MAX_NODES)
+            throw std::runtime_error("node id is too large for the node directory");
+
+         slot *chunk(ensure_chunk(id >> CHUNK_BITS));
+         if(chunk[id & CHUNK_MASK].exchange(n, std::memory_order_acq_rel) == nullptr)
+            count.fetch_add(1, std::memory_order_relaxed);
+
+         node::node_id old(limit.load(std::memory_order_relaxed));
+         while(old <= id &&
+               !limit.compare_exchange_weak(old, id + 1, std::memory_order_release,
+                  std::memory_order_relaxed))
+            ;
+      }
+
+      // calls f(id, node) for every node stored in the directory, in id order.
+      template <typename F>
+      void for_each(F f) const
+      {
+         const node::node_id end(end_id());
+         for(node::node_id id(0); id < end; id += CHUNK_SIZE) {
+            slot *chunk(get_chunk(id >> CHUNK_BITS));
+            if(chunk == nullptr)
+               continue;
+            for(size_t i(0); i < CHUNK_SIZE && id + i < end; ++i) {
+               node *n(chunk[i].load(std::memory_order_acquire));
+               if(n)
+                  f(id + i, n);
+            }
+         }
+      }
+
+      explicit node_directory(void):
+         chunks(new std::atomic<slot*>[MAX_CHUNKS])
+      {
+         for(size_t i(0); i < MAX_CHUNKS; ++i)
+            chunks[i].store(nullptr, std::memory_order_relaxed);
+      }
+
+      node_directory(const node_directory&) = delete;
+      node_directory& operator=(const node_directory&) = delete;
+
+      ~node_directory(void)
+      {
+         for(size_t i(0); i < MAX_CHUNKS; ++i)
+            delete [](chunks[i].load(std::memory_order_relaxed));
+         delete []chunks;
+      }
+};
+
+}
+
+#endif
@@ -11,6 +11,8 @@
 #include "vm/full_tuple.hpp"
 #include "utils/intrusive_list.hpp"
 #include "vm/bitmap.hpp"
+#include "vm/buffer_node.hpp"
+#include "queue/push_safe_stack.hpp"
 
 namespace db {
 
@@ -31,6 +33,10 @@ struct temporary_store {
    // incoming action tuples
    vm::full_tuple_list incoming_action_tuples;
 
+   // batches of facts sent by other threads.
+   // pushed without locking the node and drained by the thread running it.
+   queue::push_safe_intrusive_stack<vm::buffer_batch> inbox;
+
    inline tuple_list *get_incoming(const vm::predicate_id p) {
       assert(p < vm::theProgram->num_linear_predicates());
       return incoming + p;
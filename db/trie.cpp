@@ -391,7 +391,7 @@ void trie_node::convert_hash(type *type) {
    hash->total = total;
    child = (trie_node *)hash;
    assert(!is_hashed());
-   hashed = true;
+   set_hashed(true);
 
    assert(is_hashed());
 }
@@ -437,7 +437,7 @@ void trie_hash::insert_int(const int_val &val, trie_node *node) {
    node->prev = nullptr;
    node->next = old;
    if (old) old->prev = node;
-   node->bucket = buckets + bucket;
+   node->set_bucket(buckets + bucket);
 
    buckets[bucket] = node;
 }
@@ -453,7 +453,7 @@ void trie_hash::insert_uint(const uint_val &val, trie_node *node) {
    node->prev = nullptr;
    node->next = old;
    if (old) old->prev = node;
-   node->bucket = buckets + bucket;
+   node->set_bucket(buckets + bucket);
 
    buckets[bucket] = node;
 }
@@ -468,7 +468,7 @@ void trie_hash::insert_float(const float_val &val, trie_node *node) {
    node->prev = nullptr;
    node->next = old;
    if (old) old->prev = node;
-   node->bucket = buckets + bucket;
+   node->set_bucket(buckets + bucket);
 
    buckets[bucket] = node;
 }
@@ -483,7 +483,7 @@ void trie_hash::insert_node(const node_val &val, trie_node *node) {
    node->prev = nullptr;
    node->next = old;
    if (old) old->prev = node;
-   node->bucket = buckets + bucket;
+   node->set_bucket(buckets + bucket);
 
    buckets[bucket] = node;
 }
@@ -498,7 +498,7 @@ void trie_hash::insert_thread(const thread_val &val, trie_node *node) {
    node->prev = nullptr;
    node->next = old;
    if (old) old->prev = node;
-   node->bucket = buckets + bucket;
+   node->set_bucket(buckets + bucket);
 
    buckets[bucket] = node;
 }
@@ -564,7 +564,7 @@ void trie::delete_path(trie_node *node) {
    if (node == &root)  // reached root
    {
       assert(node->child == nullptr);
-      node->hashed = false;
+      node->set_hashed(false);
       return;
    }
 
@@ -574,21 +574,21 @@ void trie::delete_path(trie_node *node) {
 
    if (node->next != nullptr) node->next->prev = node->prev;
 
-   if (node->bucket != nullptr) {
+   if (node->get_bucket() != nullptr) {
       trie_hash *hash(parent->get_hash());
       hash->total--;
    }
 
    if (node->prev == nullptr) {
-      if (node->bucket != nullptr) {
-         *(node->bucket) = node->next;
+      if (node->get_bucket() != nullptr) {
+         *(node->get_bucket()) = node->next;
 
          trie_hash *hash(parent->get_hash());
 
          if (hash->total == 0) {
             delete hash;
-            node->hashed = false;
-            node->bucket = nullptr;
+            node->set_hashed(false);
+            node->set_bucket(nullptr);
             assert(parent != (trie_node *)hash);
             parent->child = nullptr;
             delete_path(parent);
@@ -625,8 +625,7 @@ size_t trie::delete_branch(trie_node *node, predicate *pred,
 
       count = leaf->get_count();
 
-      leaf->destroy(pred, alloc, gc_nodes);
-      delete leaf;
+      trie_leaf::destroy(leaf, pred, alloc, gc_nodes);
       node->child = nullptr;
 
       return count;
@@ -874,8 +873,7 @@ void trie::inner_delete_by_leaf(trie_leaf *leaf, predicate *pred,
    // cout << this << " Total " << total << " root " << root << " node " << node
    // << endl;
 
-   leaf->destroy(pred, alloc, gc_nodes);
-   delete leaf;
+   trie_leaf::destroy(leaf, pred, alloc, gc_nodes);
    node->child = nullptr;
    delete_path(node);
 
@@ -1283,7 +1281,7 @@ match_begin:
 
             trie_node **buckets(hash->buckets);
             trie_node **end_buckets(buckets + hash->num_buckets);
-            trie_node **current_bucket(node->bucket);
+            trie_node **current_bucket(node->get_bucket());
 
             if (node->next)
                ADD_ALT(parent, node->next);
@@ -23,7 +23,9 @@ class trie_hash;
 class trie_leaf;
 class tuple_trie_leaf;
 
-class trie_node : public mem::base {
+// trie nodes are not polymorphic, so they do not inherit from mem::base
+// in order to avoid the virtual table pointer.
+class trie_node {
    public:
    trie_node *parent{nullptr};
    trie_node *next{nullptr};
@@ -32,8 +34,19 @@ class trie_node : public mem::base {
 
    vm::tuple_field data;
 
-   bool hashed{false};
-   trie_node **bucket{nullptr};
+   private:
+   // bucket of the node in the hash table of the parent.
+   // the lowest bit tells if the children of the node are hashed.
+   vm::ptr_val bucket_hashed{0};
+
+   public:
+   static inline void *operator new(size_t sz) {
+      return mem::center::allocate(sz, 1);
+   }
+
+   static inline void operator delete(void *ptr, size_t sz) {
+      mem::center::deallocate(ptr, sz, 1);
+   }
 
    trie_node *get_by_int(const vm::int_val) const;
    trie_node *get_by_float(const vm::float_val) const;
@@ -41,7 +54,16 @@ class trie_node : public mem::base {
 
    void convert_hash(vm::type *);
 
-   inline bool is_hashed(void) const { return hashed; }
+   inline bool is_hashed(void) const { return bucket_hashed & 0x1; }
+   inline void set_hashed(const bool hashed) {
+      bucket_hashed = (bucket_hashed & ~(vm::ptr_val)0x1) | (vm::ptr_val)hashed;
+   }
+   inline trie_node **get_bucket(void) const {
+      return (trie_node **)(bucket_hashed & ~(vm::ptr_val)0x1);
+   }
+   inline void set_bucket(trie_node **bucket) {
+      bucket_hashed = (vm::ptr_val)bucket | (bucket_hashed & 0x1);
+   }
    inline trie_hash *get_hash(void) const { return (trie_hash *)child; }
    inline bool is_leaf(void) const { return (vm::ptr_val)child & 0x1; }
 
@@ -66,18 +88,19 @@ class trie_node : public mem::base {
 
    explicit trie_node(vm::tuple_field _data) : data(std::move(_data)) {
       assert(next == nullptr && prev == nullptr && parent == nullptr &&
-             child == nullptr && hashed == false);
+             child == nullptr && !is_hashed());
    }
 
    explicit trie_node(void)  // no data
    {
       assert(next == nullptr && prev == nullptr && parent == nullptr &&
-             child == nullptr && hashed == false);
+             child == nullptr && !is_hashed());
    }
-
-   ~trie_node(void) { }
 };
 
+static_assert(sizeof(trie_node) == 6 * sizeof(void*),
+      "trie nodes should not have a virtual table.");
+
 class trie_hash : public mem::base {
    private:
    friend class trie;
@@ -117,7 +140,9 @@ class trie_hash : public mem::base {
    ~trie_hash(void);
 };
 
-class trie_leaf : public mem::base {
+// leaves are not polymorphic in order to save the virtual table pointer,
+// functions dispatch on the type of trie instead.
+class trie_leaf {
    private:
    friend class trie_node;
    friend class trie;
@@ -126,96 +151,150 @@ class trie_leaf : public mem::base {
    friend class agg_trie_iterator;
    friend class agg_trie;
 
+   protected:
    trie_node *node;
+   // leaf of an agg_trie or a tuple_trie.
+   const bool agg;
 
-   virtual void set_next(trie_leaf *n) = 0;
-   virtual void set_prev(trie_leaf *p) = 0;
-   virtual trie_leaf *get_next() const = 0;
-   virtual trie_leaf *get_prev() const = 0;
+   private:
+   inline void set_next(trie_leaf *n);
+   inline void set_prev(trie_leaf *p);
 
    public:
-   virtual vm::ref_count get_count(void) const = 0;
+   static inline void *operator new(size_t sz) {
+      return mem::center::allocate(sz, 1);
+   }
+
+   static inline void operator delete(void *ptr, size_t sz) {
+      mem::center::deallocate(ptr, sz, 1);
+   }
+
+   inline trie_leaf *get_next() const;
+   inline trie_leaf *get_prev() const;
 
-   virtual void add_new(const vm::depth_t depth, const vm::ref_count many) = 0;
+   inline vm::ref_count get_count(void) const;
 
-   virtual void sub(const vm::depth_t depth, const vm::ref_count many) = 0;
+   inline void add_new(const vm::depth_t depth, const vm::ref_count many);
 
-   virtual bool to_delete(void) const = 0;
+   inline void sub(const vm::depth_t depth, const vm::ref_count many);
 
-   explicit trie_leaf(void) {}
+   inline bool to_delete(void) const { return get_count() == 0; }
 
-   virtual void destroy(vm::predicate *, mem::node_allocator *,
-                        vm::candidate_gc_nodes &) {}
+   // releases the leaf and its data.
+   static inline void destroy(trie_leaf *, vm::predicate *,
+                              mem::node_allocator *, vm::candidate_gc_nodes &);
+
+   explicit trie_leaf(const bool _agg) : agg(_agg) {}
 };
 
 class depth_counter : public mem::base {
    private:
    using map_count = std::map<vm::depth_t, vm::ref_count>;
-   map_count counts;
 
-   public:
-   using const_iterator = map_count::const_iterator;
+   // most facts are derived at a single depth, which is kept inline.
+   // other depths are kept in the map.
+   vm::depth_t first_depth{0};
+   vm::ref_count first_count{0};
+   map_count *others{nullptr};
 
-   inline bool empty(void) const { return counts.empty(); }
+   inline bool has_others(void) const {
+      return others != nullptr && !others->empty();
+   }
+
+   public:
+   inline bool empty(void) const { return first_count == 0 && !has_others(); }
 
    inline vm::ref_count get_count(const vm::depth_t depth) const {
-      auto it(counts.find(depth));
-      if (it == counts.end())
+      if (first_count > 0 && first_depth == depth) return first_count;
+      if (others == nullptr) return 0;
+      auto it(others->find(depth));
+      if (it == others->end())
          return 0;
       else
          return it->second;
    }
 
-   inline const_iterator begin(void) const { return counts.begin(); }
-   inline const_iterator end(void) const { return counts.end(); }
+   // calls f(depth, count) for each depth in increasing order.
+   template <typename F>
+   inline void for_each(F f) const {
+      bool first_done(first_count == 0);
+      if (others) {
+         for (auto &p : *others) {
+            if (!first_done && first_depth < p.first) {
+               f(first_depth, first_count);
+               first_done = true;
+            }
+            f(p.first, p.second);
+         }
+      }
+      if (!first_done) f(first_depth, first_count);
+   }
 
    inline vm::depth_t max_depth(void) const {
-      auto it(counts.rbegin());
-      if (it == counts.rend()) return 0;
-      return it->first;
+      vm::depth_t ret(first_count > 0 ? first_depth : 0);
+      if (has_others()) ret = std::max(ret, others->rbegin()->first);
+      return ret;
    }
 
    inline vm::depth_t min_depth(void) const {
-      auto it(counts.begin());
-      if (it == counts.end()) return 0;
-      return it->first;
+      if (!has_others()) return first_count > 0 ? first_depth : 0;
+      const vm::depth_t other(others->begin()->first);
+      if (first_count > 0) return std::min(first_depth, other);
+      return other;
    }
 
    inline void add(const vm::depth_t depth, const vm::ref_count count) {
       assert(count > 0);
 
-      auto it(counts.find(depth));
+      if (first_count > 0 && first_depth == depth) {
+         first_count += count;
+         return;
+      }
+
+      if (others) {
+         auto it(others->find(depth));
+         if (it != others->end()) {
+            it->second += count;
+            return;
+         }
+      }
 
-      if (it == counts.end()) {
-         counts[depth] = count;
-         // std::cout << "New depth " << depth << " with count " << count <<
-         // "\n";
+      if (first_count == 0) {
+         first_depth = depth;
+         first_count = count;
       } else {
-         it->second += count;
-         // std::cout << "Depth " << depth << " now with count " << it->second
-         // << "\n";
+         if (others == nullptr) others = new map_count();
+         (*others)[depth] = count;
       }
    }
 
    // decrements a count of some depth
    // returns true if the count of such depth has gone to 0
    inline bool sub(const vm::depth_t depth, const vm::ref_count count) {
-      auto it(counts.find(depth));
-
       assert(count > 0);
 
-      if (it == counts.end()) return true;
+      if (first_count > 0 && first_depth == depth) {
+         if (count >= first_count) {
+            first_count = 0;
+            return true;
+         }
+         first_count -= count;
+         return false;
+      }
+
+      if (others == nullptr) return true;
+
+      auto it(others->find(depth));
+
+      if (it == others->end()) return true;
 
       if (count > it->second)
          it->second = 0;
       else
          it->second -= count;  // count is < 0
-      // std::cout << "Depth " << depth << " dropped to count " << it->second <<
-      // "\n";
 
       if (it->second == 0) {
-         // std::cout << "Erasing depth " << depth << "\n";
-         counts.erase(it);
+         others->erase(it);
          return true;
       }
       return false;
@@ -225,50 +304,59 @@ class depth_counter : public mem::base {
    // and returns the number of references deleted
    inline vm::ref_count delete_depths_above(const vm::depth_t depth) {
       vm::ref_count ret(0);
-      while (true) {
-         auto it(counts.rbegin());
+      if (first_count > 0 && first_depth > depth) {
+         ret += first_count;
+         first_count = 0;
+      }
+      while (has_others()) {
+         auto it(others->rbegin());
 
-         if (it == counts.rend()) return ret;
          if (it->first <= depth) return ret;
          ret += it->second;
-         counts.erase(it->first);
+         others->erase(it->first);
       }
       return ret;
    }
 
    explicit depth_counter(void) {}
+
+   virtual ~depth_counter(void) {
+      if (others) delete others;
+   }
 };
 
 class tuple_trie_leaf : public trie_leaf {
    private:
    friend class trie_node;
    friend class trie;
+   friend class trie_leaf;
    friend class tuple_trie;
    friend class tuple_trie_iterator;
 
+   /// XXX this may be deleted...
+   uint32_t used{0};  // this is utilized by the VM core to manage leaves
    vm::tuple *tpl;
    vm::ref_count count{0};
-   /// XXX this may be deleted...
-   vm::ref_count used{0};  // this is utilized by the VM core to manage leaves
    depth_counter *depths;  // depth counter -- usually nullptr
 
-   virtual void set_next(trie_leaf *n) {
+   inline void set_next(trie_leaf *n) {
       tpl->__intrusive_next = (vm::tuple*)n;
    }
-   virtual void set_prev(trie_leaf *p) {
+   inline void set_prev(trie_leaf *p) {
       tpl->__intrusive_prev = (vm::tuple*)p;
    }
-   virtual trie_leaf *get_next() const {
+
+   public:
+   inline trie_leaf *get_next() const {
       return (trie_leaf*)tpl->__intrusive_next;
    }
-   virtual trie_leaf *get_prev() const {
+   inline trie_leaf *get_prev() const {
       return (trie_leaf*)tpl->__intrusive_prev;
    }
 
-   public:
    inline vm::tuple *get_underlying_tuple(void) const { return tpl; }
 
-   virtual inline vm::ref_count get_count(void) const override { return count; }
+   inline vm::ref_count get_count(void) const { return count; }
 
    inline bool has_depth_counter(void) const { return depths != nullptr; }
 
@@ -301,13 +389,6 @@ class tuple_trie_leaf : public trie_leaf {
          return depths->min_depth();
    }
 
-   inline depth_counter::const_iterator get_depth_begin(void) const {
-      return depths->begin();
-   }
-   inline depth_counter::const_iterator get_depth_end(void) const {
-      return depths->end();
-   }
-
    inline vm::ref_count delete_depths_above(const vm::depth_t depth) {
       assert(depths);
       vm::ref_count ret(depths->delete_depths_above(depth));
@@ -316,8 +397,7 @@ class tuple_trie_leaf : public trie_leaf {
       return ret;
    }
 
-   virtual inline void add_new(const vm::depth_t depth,
-                               const vm::ref_count many) override {
+   inline void add_new(const vm::depth_t depth, const vm::ref_count many) {
       assert(many > 0);
       count += many;
       if (depths) {
@@ -332,8 +412,7 @@ class tuple_trie_leaf : public trie_leaf {
       count -= many;
    }
 
-   virtual inline void sub(const vm::depth_t depth,
-                           const vm::ref_count many) override {
+   inline void sub(const vm::depth_t depth, const vm::ref_count many) {
       assert(many > 0);
       if (many > count)
          count = 0;
@@ -342,11 +421,11 @@ class tuple_trie_leaf : public trie_leaf {
       if (depths) depths->sub(depth, many);
    }
 
-   virtual inline bool to_delete(void) const override { return count == 0; }
+   inline bool to_delete(void) const { return count == 0; }
 
    explicit tuple_trie_leaf(vm::tuple *_tpl, vm::predicate *pred,
                             const vm::ref_count count, const vm::depth_t depth)
-       : trie_leaf(), tpl(_tpl) {
+       : trie_leaf(false), tpl(_tpl) {
       if (pred->is_cycle_pred())
          depths = new depth_counter();
       else
@@ -354,8 +433,8 @@ class tuple_trie_leaf : public trie_leaf {
       add_new(depth, count);
    }
 
-   virtual void destroy(vm::predicate *pred, mem::node_allocator *alloc,
-                        vm::candidate_gc_nodes &gc_nodes) override {
+   inline void destroy(vm::predicate *pred, mem::node_allocator *alloc,
+                       vm::candidate_gc_nodes &gc_nodes) {
       if (depths) delete depths;
       vm::tuple::destroy(tpl, pred, alloc, gc_nodes);
    }
@@ -664,6 +743,7 @@ class agg_trie_leaf : public trie_leaf {
    private:
    friend class trie_node;
    friend class trie;
+   friend class trie_leaf;
    friend class tuple_trie;
    friend class tuple_trie_iterator;
 
@@ -671,18 +751,19 @@ class agg_trie_leaf : public trie_leaf {
    agg_configuration *conf;
    vm::ref_count count;
 
-   public:
-
-   virtual void set_next(trie_leaf *n) {
+   inline void set_next(trie_leaf *n) {
       next = n;
    }
-   virtual void set_prev(trie_leaf *p) {
+   inline void set_prev(trie_leaf *p) {
       prev = p;
    }
-   virtual trie_leaf *get_next() const {
+
+   public:
+
+   inline trie_leaf *get_next() const {
       return next;
    }
-   virtual trie_leaf *get_prev() const {
+   inline trie_leaf *get_prev() const {
       return prev;
    }
 
@@ -690,20 +771,16 @@ class agg_trie_leaf : public trie_leaf {
 
    inline agg_configuration *get_conf(void) const { return conf; }
 
-   virtual inline vm::ref_count get_count(void) const override { return count; }
-
-   virtual inline void add_new(const vm::depth_t,
-                               const vm::ref_count) override {}
-   virtual inline void sub(const vm::depth_t, const vm::ref_count) override {}
+   inline vm::ref_count get_count(void) const { return count; }
 
    inline void set_zero_refs(void) { count = 0; }
 
-   virtual inline bool to_delete(void) const override { return count == 0; }
+   inline bool to_delete(void) const { return count == 0; }
 
    explicit agg_trie_leaf(agg_configuration *_conf)
-       : trie_leaf(), conf(_conf), count(1) {}
+       : trie_leaf(true), conf(_conf), count(1) {}
 
-   virtual ~agg_trie_leaf(void);
+   ~agg_trie_leaf(void);
 };
 
 class agg_trie_iterator : public mem::base {
@@ -776,6 +853,53 @@ class agg_trie : public trie, public mem::base {
 
    virtual ~agg_trie(void) {}
 };
+#define LEAF_DISPATCH(CALL) \
+   (agg ? static_cast<const agg_trie_leaf *>(this)->CALL \
+        : static_cast<const tuple_trie_leaf *>(this)->CALL)
+
+inline trie_leaf *trie_leaf::get_next() const { return LEAF_DISPATCH(get_next()); }
+inline trie_leaf *trie_leaf::get_prev() const { return LEAF_DISPATCH(get_prev()); }
+inline vm::ref_count trie_leaf::get_count(void) const {
+   return LEAF_DISPATCH(get_count());
+}
+
+#undef LEAF_DISPATCH
+
+inline void trie_leaf::set_next(trie_leaf *n) {
+   if (agg)
+      static_cast<agg_trie_leaf *>(this)->set_next(n);
+   else
+      static_cast<tuple_trie_leaf *>(this)->set_next(n);
+}
+
+inline void trie_leaf::set_prev(trie_leaf *p) {
+   if (agg)
+      static_cast<agg_trie_leaf *>(this)->set_prev(p);
+   else
+      static_cast<tuple_trie_leaf *>(this)->set_prev(p);
+}
+
+// aggregate leaves ignore new references.
+inline void trie_leaf::add_new(const vm::depth_t depth,
+                               const vm::ref_count many) {
+   if (!agg) static_cast<tuple_trie_leaf *>(this)->add_new(depth, many);
+}
+
+inline void trie_leaf::sub(const vm::depth_t depth, const vm::ref_count many) {
+   if (!agg) static_cast<tuple_trie_leaf *>(this)->sub(depth, many);
+}
+
+inline void trie_leaf::destroy(trie_leaf *leaf, vm::predicate *pred,
+                               mem::node_allocator *alloc,
+                               vm::candidate_gc_nodes &gc_nodes) {
+   if (leaf->agg)
+      delete static_cast<agg_trie_leaf *>(leaf);
+   else {
+      tuple_trie_leaf *tleaf(static_cast<tuple_trie_leaf *>(leaf));
+      tleaf->destroy(pred, alloc, gc_nodes);
+      delete tleaf;
+   }
+}
 }
 
 #endif
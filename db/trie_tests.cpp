@@ -1,4 +1,7 @@
 
+#include <chrono>
+#include <iostream>
+
 #include "db/trie.hpp"
 
 class DbTrieTests : public TestFixture {
@@ -112,9 +115,83 @@ class DbTrieTests : public TestFixture {
          CPPUNIT_ASSERT(trie->empty());
       }
 
+      void testDepthCounter(void)
+      {
+         db::depth_counter c;
+         CPPUNIT_ASSERT(c.empty());
+         c.add(2, 1);
+         c.add(2, 2);
+         CPPUNIT_ASSERT(c.get_count(2) == 3);
+         CPPUNIT_ASSERT(c.max_depth() == 2 && c.min_depth() == 2);
+         c.add(5, 1);
+         c.add(1, 4);
+         CPPUNIT_ASSERT(c.max_depth() == 5);
+         CPPUNIT_ASSERT(c.min_depth() == 1);
+
+         std::vector<vm::depth_t> depths;
+         c.for_each([&depths](const vm::depth_t d, const vm::ref_count) { depths.push_back(d); });
+         CPPUNIT_ASSERT(depths.size() == 3);
+         CPPUNIT_ASSERT(depths[0] == 1 && depths[1] == 2 && depths[2] == 5);
+
+         CPPUNIT_ASSERT(c.sub(2, 3));
+         CPPUNIT_ASSERT(c.get_count(2) == 0);
+         CPPUNIT_ASSERT(c.min_depth() == 1);
+         CPPUNIT_ASSERT(c.delete_depths_above(1) == 1);
+         CPPUNIT_ASSERT(c.max_depth() == 1);
+         CPPUNIT_ASSERT(!c.sub(1, 1));
+         CPPUNIT_ASSERT(c.sub(1, 3));
+         CPPUNIT_ASSERT(c.empty());
+      }
+
+#define TRIE_BENCH_FACTS 100000
+
+      // inserts and iterates over many facts, reporting the time taken
+      // and the size of the trie structures.
+      void testManyFacts(void)
+      {
+         mem::node_allocator alloc;
+         std::vector<vm::tuple*> tpls;
+         tpls.reserve(TRIE_BENCH_FACTS);
+
+         auto start(std::chrono::steady_clock::now());
+         for(size_t i(0); i < TRIE_BENCH_FACTS; ++i) {
+            vm::tuple *tpl(vm::tuple::create(f, &alloc));
+            tpl->set_int(0, i % 317);
+            tpl->set_int(1, i);
+            tpls.push_back(tpl);
+            CPPUNIT_ASSERT(trie->insert_tuple(tpl, f));
+         }
+         auto inserted(std::chrono::steady_clock::now());
+         CPPUNIT_ASSERT(trie->size() == TRIE_BENCH_FACTS);
+
+         size_t total(0);
+         for(auto it(trie->begin()); it != trie->end(); ++it)
+            total += (*it)->get_count();
+         auto iterated(std::chrono::steady_clock::now());
+         CPPUNIT_ASSERT(total == TRIE_BENCH_FACTS);
+
+         std::cout << std::endl << "trie: " << TRIE_BENCH_FACTS << " facts, "
+            << sizeof(db::trie_node) << " bytes/node, "
+            << sizeof(db::tuple_trie_leaf) << " bytes/leaf, insert "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(inserted - start).count()
+            << "ms, iterate "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(iterated - inserted).count()
+            << "ms" << std::endl;
+
+         vm::candidate_gc_nodes gc_nodes;
+         for(vm::tuple *tpl : tpls) {
+            db::trie::delete_info inf(trie->delete_tuple(tpl, f));
+            CPPUNIT_ASSERT(inf.is_valid() && inf.to_delete());
+            inf.perform_delete(f, &alloc, gc_nodes);
+         }
+         CPPUNIT_ASSERT(trie->empty());
+      }
+
       CPPUNIT_TEST_SUITE(DbTrieTests);
 
       CPPUNIT_TEST(testTrie);
+      CPPUNIT_TEST(testDepthCounter);
+      CPPUNIT_TEST(testManyFacts);
       CPPUNIT_TEST_SUITE_END();
 };
 
@@ -0,0 +1,100 @@
+
+#ifndef EXTERNAL_FLOAT_VECTOR_HPP
+#define EXTERNAL_FLOAT_VECTOR_HPP
+
+#include <algorithm>
+
+#include "runtime/objs.hpp"
+
+namespace vm
+{
+namespace external
+{
+
+// Scratch buffer of floats used by convolve to index into its list
+// arguments instead of walking cons cells for every entry.
+// Lists of belief propagation messages are short, so the elements are
+// kept inside the object unless there are more than FLOAT_VECTOR_INLINE.
+struct float_vector
+{
+#define FLOAT_VECTOR_INLINE 16
+
+   private:
+
+      size_t size;
+      size_t capacity;
+      vm::float_val *elems;
+      vm::float_val inline_elems[FLOAT_VECTOR_INLINE];
+
+      inline void allocate(const size_t n)
+      {
+         capacity = std::max(n, (size_t)FLOAT_VECTOR_INLINE);
+         if(n <= FLOAT_VECTOR_INLINE)
+            elems = inline_elems;
+         else
+            elems = mem::allocator<vm::float_val>().allocate(n);
+      }
+
+      void grow(void)
+      {
+         vm::float_val *old(elems);
+         const size_t old_capacity(capacity);
+         capacity = std::max(2 * old_capacity, (size_t)FLOAT_VECTOR_INLINE);
+         elems = mem::allocator<vm::float_val>().allocate(capacity);
+         std::copy(old, old + size, elems);
+         if(old != inline_elems)
+            mem::allocator<vm::float_val>().deallocate(old, old_capacity);
+      }
+
+   public:
+
+      inline size_t get_size(void) const { return size; }
+      inline vm::float_val get_item(const size_t i) const { return elems[i]; }
+      inline void set_item(const size_t i, const vm::float_val f) { elems[i] = f; }
+      inline vm::float_val *get_data(void) { return elems; }
+      inline const vm::float_val *get_data(void) const { return elems; }
+
+      inline void push_back(const vm::float_val f)
+      {
+         if(size == capacity)
+            grow();
+         elems[size++] = f;
+      }
+
+      // list with the first n elements.
+      inline runtime::cons* to_list(const size_t n) const
+      {
+         assert(n <= size);
+         runtime::cons *ptr(runtime::cons::null_list());
+         for(size_t i(n); i > 0; --i) {
+            vm::tuple_field f;
+            f.float_field = elems[i - 1];
+            ptr = runtime::cons::create(ptr, f, vm::TYPE_FLOAT);
+         }
+         return ptr;
+      }
+
+      explicit float_vector(const size_t n): size(n) { allocate(n); }
+
+      // copies the list in a single walk.
+      explicit float_vector(runtime::cons *ls): size(0)
+      {
+         allocate(FLOAT_VECTOR_INLINE);
+         for(; !runtime::cons::is_null(ls); ls = ls->get_tail())
+            push_back(FIELD_FLOAT(ls->get_head()));
+      }
+
+      float_vector(const float_vector&) = delete;
+      float_vector& operator=(const float_vector&) = delete;
+
+      ~float_vector(void)
+      {
+         if(elems != inline_elems)
+            mem::allocator<vm::float_val>().deallocate(elems, capacity);
+      }
+};
+
+}
+}
+
+#endif
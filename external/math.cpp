@@ -5,6 +5,7 @@
 
 #include "runtime/objs.hpp"
 #include "external/math.hpp"
+#include "external/float_vector.hpp"
 #include "vm/all.hpp"
 
 using namespace std;
@@ -234,37 +235,34 @@ convolve(EXTERNAL_ARG(bin_fact), EXTERNAL_ARG(ls))
 {
    DECLARE_LIST(bin_fact);
    DECLARE_LIST(ls);
-   const size_t length(runtime::cons::length((runtime::cons*)ls));
    
-   stack_float_list vals;
-   tuple_field def;
-   def.float_field = 0.0;
+   float_vector bin((runtime::cons*)bin_fact);
+   float_vector v((runtime::cons*)ls);
+   const size_t length(v.get_size());
+   const size_t bin_size(bin.get_size());
+   const float_val *other(v.get_data());
+   const float_val *val_bin(bin.get_data());
+   float_vector ret(length);
    
    for(size_t x(0); x < length; ++x) {
       float_val sum(0.0);
-      runtime::cons *ptr((runtime::cons*)ls);
       
-      size_t y(0);
-      while(!runtime::cons::is_null(ptr)) {
-         const float_val other(ptr->get_head().float_field);
-         const float_val val_bin(runtime::cons::get((runtime::cons*)bin_fact, x + y * length, def).float_field);
+      for(size_t y(0); y < length; ++y) {
+         const size_t pos(x + y * length);
+         // missing factors count as 0.0
+         const float_val b(pos < bin_size ? val_bin[pos] : 0.0);
 
-         assert(!std::isnan(other));
-         assert(!std::isnan(val_bin));
-         sum += std::exp(val_bin + other);
-         
-         ptr = ptr->get_tail();
-         ++y;
+         assert(!std::isnan(other[y]));
+         assert(!std::isnan(b));
+         sum += std::exp(b + other[y]);
       }
       
       if(sum == 0) sum = std::numeric_limits<float_val>::min();
       
-      sum = std::log(sum);
-      
-      vals.push(sum);
+      ret.set_item(x, std::log(sum));
    }
    
-   runtime::cons *ptr(from_float_stack_to_list(vals));
+   runtime::cons *ptr(ret.to_list(length));
       
 	RETURN_LIST(ptr);
 }
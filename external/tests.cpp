@@ -1,5 +1,9 @@
+#include <cmath>
+
 
 #include "external/core.hpp"
+#include "external/math.hpp"
+#include "external/float_vector.hpp"
 
 class ExternalTests : public TestFixture {
    public:
@@ -202,6 +206,91 @@ class ExternalTests : public TestFixture {
          CPPUNIT_ASSERT(partition_grid(399, 399, 400, 400) == 7);
       }
 
+      static vm::argument make_float_list(const std::vector<vm::float_val>& vals)
+      {
+         runtime::cons *ls(runtime::cons::null_list());
+         for(size_t i(vals.size()); i > 0; --i) {
+            vm::tuple_field f;
+            f.float_field = vals[i - 1];
+            ls = runtime::cons::create(ls, f, vm::TYPE_FLOAT);
+         }
+         vm::argument arg;
+         SET_FIELD_CONS(arg, ls);
+         return arg;
+      }
+
+      static std::vector<vm::float_val> read_float_list(const vm::argument arg)
+      {
+         std::vector<vm::float_val> ret;
+         for(runtime::cons *ls(FIELD_CONS(arg)); !runtime::cons::is_null(ls); ls = ls->get_tail())
+            ret.push_back(FIELD_FLOAT(ls->get_head()));
+         return ret;
+      }
+
+      void testFloatLists(void)
+      {
+         const std::vector<vm::float_val> a = {1.0, -2.5, 3.0, 0.5, 4.0};
+         const std::vector<vm::float_val> b = {0.5, 1.5, -1.0, 2.0, 1.0, 7.0};
+
+         std::vector<vm::float_val> sum(read_float_list(
+                  vm::external::addfloatlists(make_float_list(a), make_float_list(b))));
+         CPPUNIT_ASSERT(sum.size() == a.size());
+         for(size_t i(0); i < a.size(); ++i)
+            CPPUNIT_ASSERT(sum[i] == a[i] + b[i]);
+
+         // a factor longer than the inline buffer.
+         std::vector<vm::float_val> big_bin, big_msg;
+         for(size_t i(0); i < 20 * 20; ++i)
+            big_bin.push_back(0.01 * (vm::float_val)(i % 37));
+         for(size_t i(0); i < 20; ++i)
+            big_msg.push_back(-0.1 * (vm::float_val)i);
+         std::vector<vm::float_val> big_conv(read_float_list(
+                  vm::external::convolve(make_float_list(big_bin), make_float_list(big_msg))));
+         CPPUNIT_ASSERT(big_conv.size() == big_msg.size());
+         for(size_t x(0); x < big_msg.size(); ++x) {
+            vm::float_val sum(0.0);
+            for(size_t y(0); y < big_msg.size(); ++y)
+               sum += std::exp(big_bin[x + y * big_msg.size()] + big_msg[y]);
+            CPPUNIT_ASSERT(std::abs(big_conv[x] - std::log(sum)) < 1e-9);
+         }
+
+         std::vector<vm::float_val> diff(read_float_list(
+                  vm::external::divide(make_float_list(a), make_float_list(b))));
+         CPPUNIT_ASSERT(diff.size() == a.size());
+         for(size_t i(0); i < a.size(); ++i)
+            CPPUNIT_ASSERT(diff[i] == a[i] - b[i]);
+
+         std::vector<vm::float_val> norm(read_float_list(
+                  vm::external::normalize(make_float_list(a))));
+         CPPUNIT_ASSERT(norm.size() == a.size());
+         vm::float_val total(0.0);
+         for(size_t i(0); i < a.size(); ++i) {
+            total += std::exp(norm[i]);
+            CPPUNIT_ASSERT(std::abs((norm[i] - norm[0]) - (a[i] - a[0])) < 1e-9);
+         }
+         CPPUNIT_ASSERT(std::abs(total - 1.0) < 1e-9);
+
+         // a 2x2 factor with the missing entry counting as 0.
+         const std::vector<vm::float_val> bin = {0.0, 1.0, 2.0};
+         const std::vector<vm::float_val> msg = {0.5, -0.5};
+         std::vector<vm::float_val> conv(read_float_list(
+                  vm::external::convolve(make_float_list(bin), make_float_list(msg))));
+         CPPUNIT_ASSERT(conv.size() == 2);
+         CPPUNIT_ASSERT(std::abs(conv[0] - std::log(std::exp(0.5) + std::exp(1.5))) < 1e-9);
+         CPPUNIT_ASSERT(std::abs(conv[1] - std::log(std::exp(1.5) + std::exp(-0.5))) < 1e-9);
+      }
+
+      void testFloatVector(void)
+      {
+         // an empty buffer must still grow.
+         vm::external::float_vector v((size_t)0);
+         for(size_t i(0); i < 40; ++i)
+            v.push_back((vm::float_val)i);
+         CPPUNIT_ASSERT(v.get_size() == 40);
+         for(size_t i(0); i < 40; ++i)
+            CPPUNIT_ASSERT(v.get_item(i) == (vm::float_val)i);
+      }
+
       void tearDown(void)
       {
          delete vm::All;
@@ -212,6 +301,8 @@ class ExternalTests : public TestFixture {
       CPPUNIT_TEST(testPartitionHorizontal);
       CPPUNIT_TEST(testPartitionVertical);
       CPPUNIT_TEST(testPartitionGrid);
+      CPPUNIT_TEST(testFloatLists);
+      CPPUNIT_TEST(testFloatVector);
       CPPUNIT_TEST_SUITE_END();
 };
 
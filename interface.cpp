@@ -25,6 +25,14 @@ bool dump_database = false;
 bool time_execution = false;
 bool scheduling_mechanism = true;
 bool work_stealing = true;
+bool pin_threads = false;
+bool graph_partitioning = true;
+bool node_migration = true;
+bool bsp_mode = false;
+sched::vertex_order node_ordering = sched::ORDER_ID;
+bool relaxed_priorities = false;
+bool bucket_priorities = false;
+double bucket_width = 0.0;
 
 static inline size_t num_cpus_available(void) {
    return (size_t)sysconf(_SC_NPROCESSORS_ONLN);
@@ -62,7 +70,17 @@ void parse_sched(char* sched) {
    if (strlen(sched) < 2) fail_sched(sched);
 
    // attempt to parse the scheduler string
-   match_threads("th", sched) || fail_sched(sched);
+   if (match_threads("thm", sched))
+      relaxed_priorities = true;
+   else if (match_threads("thd", sched)) {
+      bucket_priorities = true;
+      const char* width(strchr(sched, ':'));
+      if (width) {
+         bucket_width = atof(width + 1);
+         if (bucket_width <= 0.0) fail_sched(sched);
+      }
+   } else
+      match_threads("th", sched) || fail_sched(sched);
 
    if (num_threads == 0) {
       cerr << "Error: invalid number of threads" << endl;
@@ -70,9 +88,28 @@ void parse_sched(char* sched) {
    }
 }
 
+void parse_node_order(char* order) {
+   assert(order != NULL);
+
+   if (strcmp(order, "id") == 0)
+      node_ordering = sched::ORDER_ID;
+   else if (strcmp(order, "rcm") == 0)
+      node_ordering = sched::ORDER_RCM;
+   else if (strcmp(order, "degree") == 0)
+      node_ordering = sched::ORDER_DEGREE;
+   else if (strcmp(order, "bfs") == 0)
+      node_ordering = sched::ORDER_BFS;
+   else {
+      cerr << "Error: invalid node order " << order << endl;
+      exit(EXIT_FAILURE);
+   }
+}
+
 void help_schedulers(void) {
    cerr << "\t-c <scheduler>\tselect scheduling type" << endl;
    cerr << "\t\t\tthX multithreaded scheduler with task stealing" << endl;
+   cerr << "\t\t\tthmX multithreaded scheduler with relaxed (MultiQueue) priority queues" << endl;
+   cerr << "\t\t\tthdX[:W] multithreaded scheduler with delta-stepping priority buckets of width W (tuned if omitted)" << endl;
 }
 
 static inline void finish(void) {}
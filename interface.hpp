@@ -4,6 +4,7 @@
 
 #include "vm/state.hpp"
 #include "machine.hpp"
+#include "thread/partition.hpp"
 
 extern size_t num_threads;
 extern bool show_database;
@@ -11,8 +12,17 @@ extern bool dump_database;
 extern bool time_execution;
 extern bool scheduling_mechanism;
 extern bool work_stealing;
+extern bool pin_threads;
+extern bool graph_partitioning;
+extern bool node_migration;
+extern bool bsp_mode;
+extern sched::vertex_order node_ordering;
+extern bool relaxed_priorities;
+extern bool bucket_priorities;
+extern double bucket_width;
 
 void parse_sched(char *);
+void parse_node_order(char *);
 void help_schedulers(void);
 bool run_program(process::machine&);
 
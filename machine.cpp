@@ -11,9 +11,11 @@
 #include "mem/stat.hpp"
 #include "stat/stat.hpp"
 #include "utils/fs.hpp"
+#include "vm/reader.hpp"
 #include "utils/random.hpp"
 #include "interface.hpp"
 #include "runtime/objs.hpp"
+#include "thread/partition.hpp"
 
 using namespace process;
 using namespace db;
@@ -111,6 +113,9 @@ void machine::slice_function(void) {
 #endif
 
 void machine::init_sched(const process_id id) {
+   // pin the thread before creating its memory pool and nodes so that
+   // their pages are first touched on the local NUMA node.
+   if (pin_threads) pin_current_thread(thread_cpus[id]);
    // ensure own memory pool
    mem::ensure_pool();
 #ifdef INSTRUMENTATION
@@ -120,10 +125,12 @@ void machine::init_sched(const process_id id) {
    utils::all_stats[id] = new utils::lock_stat();
    utils::_stat = utils::all_stats[id];
 #endif
+   runtime::set_current_owner(id + 1);
    all->SCHEDS[id] = new sched::thread(id);
    utils::set_random_generator(all->SCHEDS[id]->get_random());
    all->SCHEDS[id]->loop();
    all->SCHEDS[id]->commit_nodes();
+   runtime::set_current_owner(0);
 #ifdef MEMORY_STATISTICS
    merge_memory_statistics();
 #endif
@@ -140,6 +147,7 @@ void machine::start(void) {
 #endif
 
    sched::thread::init_barriers(all->NUM_THREADS);
+   runtime::init_owners(all->NUM_THREADS);
 #if defined(LOCK_STATISTICS) || defined(FACT_STATISTICS)
    utils::all_stats.resize(all->NUM_THREADS, NULL);
 #endif
@@ -152,6 +160,20 @@ void machine::start(void) {
 
    for (size_t i(1); i < all->NUM_THREADS; ++i) threads[i]->join();
 
+   // objects queued after their owner thread stopped looking at its queue.
+   // teardown drops the remaining objects from this thread.
+   {
+      candidate_gc_nodes gc_nodes;
+      runtime::stop_owners(gc_nodes);
+#ifdef GC_NODES
+      for (auto x : gc_nodes) {
+         db::node *n((db::node *)x);
+         if (n->garbage_collect()) all->SCHEDS[0]->delete_node(n);
+      }
+      all->SCHEDS[0]->commit_nodes();
+#endif
+   }
+
 #if 0
    cout << "Total Facts: " << this->all->DATABASE->total_facts() << endl;
    cout << "Total Nodes: " << this->all->DATABASE->num_nodes() << endl;
@@ -162,6 +184,13 @@ void machine::start(void) {
    utils::mutex::print_statistics(mstat);
 #ifdef FACT_STATISTICS
    cout << "facts_end: " << vm::All->DATABASE->total_facts() << endl;
+   for (size_t i(0); i < theProgram->num_linear_predicates(); ++i) {
+      const predicate *pred(theProgram->get_linear_predicate(i));
+      if (pred->stat_to_hash_table == 0 && pred->stat_to_list == 0) continue;
+      cout << "index_conversions " << pred->get_name() << ": "
+           << pred->stat_to_hash_table << " to hash table / "
+           << pred->stat_to_list << " to list" << endl;
+   }
 #endif
 #endif
 
@@ -195,9 +224,78 @@ void machine::setup_threads(const size_t th) {
    this->all->MACHINE = this;
    this->all->SCHEDS.resize(th, nullptr);
 
-   nodes_per_thread = total_nodes() / num_threads;
-   if(nodes_per_thread * num_threads < total_nodes())
-      nodes_per_thread++;
+   assign_nodes();
+
+   thread_cpus.resize(th, 0);
+   thread_sockets.resize(th, 0);
+   if (pin_threads) assign_cpus();
+}
+
+void machine::assign_nodes(void) {
+   const size_t n(total_nodes());
+   const size_t th(all->NUM_THREADS);
+   size_t nodes_per_thread(n / th);
+   if (nodes_per_thread * th < n) nodes_per_thread++;
+   // nodes in the order they are created and the thread of each node.
+   vector<size_t> order;
+   vector<size_t> part;
+
+#ifndef COMPILED
+   const bool partition(th > 1 && graph_partitioning);
+   if (partition || node_ordering != sched::ORDER_ID) {
+      vector<pair<node_val, node_val>> axioms;
+      all->PROGRAM->read_edge_axioms(axioms);
+      vector<pair<size_t, size_t>> edges;
+      edges.reserve(axioms.size());
+      for (const auto& e : axioms)
+         edges.push_back(make_pair((size_t)e.first, (size_t)e.second));
+
+      if (!edges.empty()) {
+         order = sched::order_graph(n, edges, node_ordering);
+         if (partition) {
+            sched::graph_partition p(sched::partition_graph(n, edges, th));
+            part.swap(p.part);
+            if (time_execution)
+               cout << "Partition: edge cut " << p.edge_cut << " of "
+                    << p.total_edges << " edges, balance " << p.balance
+                    << endl;
+         }
+      }
+   }
+#endif
+
+   if (order.empty()) {
+      // each thread gets a contiguous range of node ids.
+      owned_ids.resize(n);
+      for (size_t i(0); i < n; ++i) owned_ids[i] = i;
+      owned_start.resize(th + 1);
+      for (size_t i(0); i <= th; ++i)
+         owned_start[i] = min(n, i * nodes_per_thread);
+      return;
+   }
+   if (part.empty()) {
+      // each thread gets a contiguous range of the node order.
+      part.resize(n);
+      for (size_t i(0); i < n; ++i) part[order[i]] = i / nodes_per_thread;
+   }
+
+   owned_start.assign(th + 1, 0);
+   for (size_t i(0); i < n; ++i) owned_start[part[i] + 1]++;
+   for (size_t i(0); i < th; ++i) owned_start[i + 1] += owned_start[i];
+   owned_ids.resize(n);
+   vector<size_t> pos(owned_start.begin(), owned_start.end() - 1);
+   for (const size_t id : order) owned_ids[pos[part[id]]++] = id;
+}
+
+void machine::assign_cpus(void) {
+   // threads with consecutive ids (and thus node ranges) are
+   // placed on the same socket as much as possible.
+   const vector<size_t> cpus(cpus_by_socket());
+
+   for (size_t i(0); i < all->NUM_THREADS; ++i) {
+      thread_cpus[i] = cpus[i % cpus.size()];
+      thread_sockets[i] = cpu_socket(thread_cpus[i]);
+   }
 }
 
 void machine::init(const machine_arguments& margs) {
@@ -241,13 +339,17 @@ machine::machine(const string& file, const size_t th,
    init(margs);
    bool added_data_file(false);
 
-   theProgram = all->PROGRAM = new vm::program(file);
+   // the file is mapped once for the byte-code and the node table.
+   const mapped_file code(file);
+   theProgram = all->PROGRAM = new vm::program(code, file);
 
    if (this->all->PROGRAM->is_data())
       throw machine_error(string("cannot run data files"));
+   // not open when there is no data file.
+   const mapped_file data_code(data_file);
    if (data_file != string("")) {
       if (file_exists(data_file)) {
-         vm::program data(data_file);
+         vm::program data(data_code, data_file);
          if (!this->all->PROGRAM->add_data_file(data)) {
             throw machine_error(string("could not import data file"));
          }
@@ -259,9 +361,12 @@ machine::machine(const string& file, const size_t th,
    }
 
    all->check_arguments(theProgram->num_args_needed());
-   auto fp(
-       program::bypass_bytecode_header(added_data_file ? data_file : filename));
-   all->DATABASE = new database(*fp);
+   const mapped_file& fp(added_data_file ? data_code : code);
+   const utils::byte *table(program::bypass_bytecode_header(fp));
+   if (table == nullptr)
+      throw load_file_error(added_data_file ? data_file : filename,
+                            string("could not read node table"));
+   all->DATABASE = new database(table);
    setup_threads(th);
 }
 #endif
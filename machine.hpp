@@ -24,7 +24,13 @@ private:
    vm::all *all;
    std::string filename;
 
-   size_t nodes_per_thread;
+   // nodes of thread 'i' are owned_ids[owned_start[i]] ... owned_ids[owned_start[i + 1] - 1].
+   std::vector<db::node::node_id> owned_ids;
+   std::vector<size_t> owned_start;
+
+   // cpu and socket assigned to each thread.
+   std::vector<size_t> thread_cpus;
+   std::vector<size_t> thread_sockets;
    
 #ifdef INSTRUMENTATION
    std::thread *alarm_thread{nullptr};
@@ -35,6 +41,8 @@ private:
    void slice_function(void);
    void set_timer(void);
    void setup_threads(const size_t);
+   void assign_nodes(void);
+   void assign_cpus(void);
    void init(const vm::machine_arguments&);
 
    inline size_t total_nodes(void) const
@@ -44,19 +52,25 @@ private:
    
 public:
 
-   db::node::node_id find_first_node(const vm::process_id id) const
+   // ids of the initial nodes owned by thread 'id', in creation order.
+   inline const db::node::node_id *owned_nodes_begin(const vm::process_id id) const
    {
-      return std::min(total_nodes(), id * nodes_per_thread);
+      return owned_ids.data() + owned_start[id];
    }
 
-   db::node::node_id find_last_node(const vm::process_id id) const
+   inline const db::node::node_id *owned_nodes_end(const vm::process_id id) const
    {
-      return find_first_node(id + 1);
+      return owned_ids.data() + owned_start[id + 1];
    }
 
    inline size_t find_owned_nodes(const vm::process_id id) const
    {
-      return find_last_node(id) - find_first_node(id);
+      return owned_start[id + 1] - owned_start[id];
+   }
+
+   inline size_t find_thread_socket(const vm::process_id id) const
+   {
+      return thread_sockets[id];
    }
    
    vm::all *get_all(void) const { return this->all; }
@@ -34,6 +34,11 @@ static void help(void) {
    help_schedulers();
    cerr << "\t-n \t\tno dynamic scheduling" << endl;
    cerr << "\t-w \t\tdisable work stealing" << endl;
+   cerr << "\t-a \t\tpin threads to cores (NUMA aware)" << endl;
+   cerr << "\t-g \t\tassign nodes to threads by id instead of partitioning the graph" << endl;
+   cerr << "\t-o <order>\tcreate nodes in id, rcm, degree or bfs order" << endl;
+   cerr << "\t-m \t\tdo not move static nodes closer to their messages" << endl;
+   cerr << "\t-b \t\tbulk synchronous execution (supersteps)" << endl;
    cerr << "\t-t \t\ttime execution" << endl;
 #ifdef INSTRUMENTATION
    cerr << "\t-i <file>\tdump time statistics" << endl;
@@ -99,6 +104,24 @@ static vm::machine_arguments read_arguments(int argc, char **argv) {
          case 'w':
             work_stealing = false;
             break;
+         case 'a':
+            pin_threads = true;
+            break;
+         case 'g':
+            graph_partitioning = false;
+            break;
+         case 'b':
+            bsp_mode = true;
+            break;
+         case 'm':
+            node_migration = false;
+            break;
+         case 'o':
+            if (argc < 2) help();
+            parse_node_order(argv[1]);
+            argc--;
+            argv++;
+            break;
          case 'h':
             help();
             break;
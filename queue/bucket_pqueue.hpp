@@ -0,0 +1,295 @@
+
+#ifndef QUEUE_BUCKET_PQUEUE_HPP
+#define QUEUE_BUCKET_PQUEUE_HPP
+
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "mem/allocator.hpp"
+#include "queue/intrusive_implementation.hpp"
+#include "queue/heap_implementation.hpp"
+
+namespace queue
+{
+
+// bucket priority queue for delta-stepping (Meyer and Sanders, 2003).
+// priorities are grouped into buckets of width 'delta' and the nodes of a
+// bucket are popped in any order, making insert, remove and pop O(1).
+// a window of QUEUE_BUCKETS buckets is kept in a circular array; nodes with
+// priorities past the window go to an overflow bucket that is spread when
+// the window becomes empty. when the width is 0 it is tuned from the range
+// of priorities found in the overflow bucket every time it is spread.
+// the position of each node in its bucket is kept in the intrusive pos.
+// the queue has no lock, callers must synchronize.
+template <class T>
+class intrusive_bucket_pqueue
+{
+public:
+
+   typedef T* heap_object;
+   typedef std::vector<heap_object, mem::allocator<heap_object> > bucket;
+
+#define QUEUE_BUCKETS 64
+#define QUEUE_BUCKET_MAX_KEY ((int64_t)1 << 62)
+
+   queue_id_t queue_number;
+
+private:
+
+   heap_type typ{HEAP_ASC};
+   // 0 if the width is tuned automatically.
+   double fixed_delta;
+   // 0 until the first tuning.
+   double delta;
+   bucket window[QUEUE_BUCKETS];
+   bucket overflow;
+   // key of the bucket window[first].
+   int64_t base{0};
+   size_t first{0};
+   // buckets before window[first + cur] are empty.
+   size_t cur{0};
+   size_t total{0};
+
+   inline double value(const double prio) const
+   {
+      return typ == HEAP_ASC ? prio : -prio;
+   }
+
+   inline int64_t key(const double prio) const
+   {
+      const double k(std::floor(value(prio) / delta));
+      if(!(k < (double)QUEUE_BUCKET_MAX_KEY))
+         return QUEUE_BUCKET_MAX_KEY;
+      if(!(k > -(double)QUEUE_BUCKET_MAX_KEY))
+         return -QUEUE_BUCKET_MAX_KEY;
+      return (int64_t)k;
+   }
+
+   inline bucket& slot(const size_t i) { return window[(first + i) % QUEUE_BUCKETS]; }
+
+   // distance between two keys. keys span up to 2^63, so the
+   // difference is computed in unsigned arithmetic to avoid overflow.
+   static inline uint64_t distance(const int64_t from, const int64_t to)
+   {
+      assert(to >= from);
+      return (uint64_t)to - (uint64_t)from;
+   }
+
+   inline bucket& bucket_of(const double prio)
+   {
+      if(delta == 0.0)
+         return overflow;
+      const uint64_t d(distance(base, key(prio)));
+      if(d < QUEUE_BUCKETS)
+         return slot(d);
+      return overflow;
+   }
+
+   inline void push(bucket& b, heap_object node)
+   {
+      __INTRUSIVE_POS(node) = b.size();
+      b.push_back(node);
+   }
+
+   inline void unlink(heap_object node)
+   {
+      bucket& b(bucket_of(__INTRUSIVE_PRIORITY(node)));
+      const size_t pos(__INTRUSIVE_POS(node));
+      assert(pos < b.size() && b[pos] == node);
+      heap_object last(b.back());
+      b[pos] = last;
+      __INTRUSIVE_POS(last) = pos;
+      b.pop_back();
+   }
+
+   // moves the window down so that it starts at key 'k'.
+   // buckets that fall out of the window go to the overflow bucket.
+   inline void shift_down(const int64_t k)
+   {
+      const uint64_t d(distance(k, base));
+      const size_t drop(d >= QUEUE_BUCKETS ? QUEUE_BUCKETS : (size_t)d);
+      for(size_t i(QUEUE_BUCKETS - drop); i < QUEUE_BUCKETS; ++i) {
+         bucket& b(slot(i));
+         for(heap_object node : b)
+            push(overflow, node);
+         b.clear();
+      }
+      first = (first + QUEUE_BUCKETS - drop) % QUEUE_BUCKETS;
+      base = k;
+      cur = 0;
+   }
+
+   inline void tune(void)
+   {
+      double lo(0.0), hi(0.0);
+      bool found(false);
+      for(heap_object node : overflow) {
+         const double v(value(__INTRUSIVE_PRIORITY(node)));
+         if(!std::isfinite(v))
+            continue;
+         if(!found || v < lo)
+            lo = v;
+         if(!found || v > hi)
+            hi = v;
+         found = true;
+      }
+      if(hi > lo)
+         delta = (hi - lo) / (QUEUE_BUCKETS - 1);
+      else if(lo != 0.0)
+         delta = std::fabs(lo) / QUEUE_BUCKETS;
+      else
+         delta = 1.0;
+   }
+
+   // called when the window is empty.
+   void spread(void)
+   {
+      assert(!overflow.empty());
+      if(fixed_delta == 0.0)
+         tune();
+      base = QUEUE_BUCKET_MAX_KEY;
+      for(heap_object node : overflow)
+         base = std::min(base, key(__INTRUSIVE_PRIORITY(node)));
+      first = 0;
+      cur = 0;
+      bucket rest;
+      rest.swap(overflow);
+      for(heap_object node : rest)
+         push(bucket_of(__INTRUSIVE_PRIORITY(node)), node);
+   }
+
+   // moves 'cur' to the first non empty bucket.
+   inline bucket& current(void)
+   {
+      assert(total > 0);
+      if(total == overflow.size())
+         spread();
+      while(slot(cur).empty())
+         cur++;
+      return slot(cur);
+   }
+
+public:
+
+   inline bool empty(void) const { return total == 0; }
+   inline size_t size(void) const { return total; }
+   inline double get_delta(void) const { return delta; }
+
+   // next node to be popped.
+   inline heap_object front(void)
+   {
+      return current().back();
+   }
+
+   inline void do_insert(heap_object node, const double prio)
+   {
+      __INTRUSIVE_PRIORITY(node) = prio;
+      __INTRUSIVE_QUEUE(node) = queue_number;
+      total++;
+
+      if(delta == 0.0) {
+         push(overflow, node);
+         return;
+      }
+      const int64_t k(key(prio));
+      if(k < base)
+         shift_down(k);
+      const uint64_t d(distance(base, k));
+      if(d < QUEUE_BUCKETS) {
+         push(slot(d), node);
+         cur = std::min(cur, (size_t)d);
+      } else
+         push(overflow, node);
+   }
+
+   inline void start_initial_insert(const size_t many)
+   {
+      overflow.reserve(many);
+   }
+
+   inline void initial_fast_insert(heap_object node, const double prio, const size_t)
+   {
+      assert(__INTRUSIVE_QUEUE(node) != queue_number);
+      do_insert(node, prio);
+   }
+
+   heap_object do_pop(const queue_id_t new_state = queue_no_queue)
+   {
+      if(empty())
+         return nullptr;
+
+      bucket& b(current());
+      heap_object node(b.back());
+      b.pop_back();
+      total--;
+      assert(__INTRUSIVE_QUEUE(node) == queue_number);
+      __INTRUSIVE_QUEUE(node) = new_state;
+      return node;
+   }
+
+   void do_remove(heap_object node, const queue_id_t new_state = queue_no_queue)
+   {
+      unlink(node);
+      total--;
+      __INTRUSIVE_QUEUE(node) = new_state;
+   }
+
+   // steals whole buckets, starting from the worst priorities.
+   // when the worst bucket alone is too big only part of it is taken.
+   inline size_t do_pop_half(heap_object *buffer, const size_t max, const queue_id_t new_state)
+   {
+      const size_t half(std::min(max, total / 2));
+      size_t got(0);
+
+      for(size_t i(QUEUE_BUCKETS + 1); i > 0 && got < half; --i) {
+         bucket& b(i == QUEUE_BUCKETS + 1 ? overflow : slot(i - 1));
+         if(b.empty())
+            continue;
+         if(got > 0 && got + b.size() > half)
+            break;
+         while(!b.empty() && got < half) {
+            heap_object node(b.back());
+            b.pop_back();
+            __INTRUSIVE_QUEUE(node) = new_state;
+            buffer[got++] = node;
+         }
+      }
+
+      total -= got;
+      return got;
+   }
+
+   inline void do_move_node(heap_object node, const double new_prio)
+   {
+      if(__INTRUSIVE_QUEUE(node) != queue_number)
+         return; // not in the queue
+      unlink(node);
+      total--;
+      do_insert(node, new_prio);
+   }
+
+   void set_type(const heap_type _typ)
+   {
+      assert(empty());
+      typ = _typ;
+   }
+
+   inline bool compare(const double v1, const double v2) const
+   {
+      return typ == HEAP_ASC ? v1 <= v2 : v1 >= v2;
+   }
+
+   explicit intrusive_bucket_pqueue(const queue_id_t id, const double _delta = 0.0):
+      queue_number(id), fixed_delta(_delta), delta(_delta)
+   {
+      assert(_delta >= 0.0);
+   }
+};
+
+#undef QUEUE_BUCKET_MAX_KEY
+
+}
+
+#endif
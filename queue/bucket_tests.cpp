@@ -0,0 +1,159 @@
+
+#include <vector>
+#include <cmath>
+
+#include "queue/bucket_pqueue.hpp"
+
+class QueueBucketTests : public TestFixture {
+   public:
+
+#define BUCKET_TEST_ITEMS 1000
+#define BUCKET_TEST_QUEUE 1
+
+      struct item {
+         DECLARE_DOUBLE_QUEUE_NODE(item);
+      };
+
+      typedef queue::intrusive_bucket_pqueue<item> bucket_queue;
+
+      static double random_priority(size_t& seed)
+      {
+         seed = seed * 1103515245 + 12345;
+         return (double)((seed >> 8) % 100000) / 10.0;
+      }
+
+      // pops everything and checks that no node comes out more than
+      // 'delta' after a better one.
+      static void pop_all(bucket_queue& q, const heap_type typ, const size_t expected)
+      {
+         size_t n(0);
+         bool first(true);
+         double worst(0.0);
+         while(!q.empty()) {
+            item *it(q.do_pop());
+            CPPUNIT_ASSERT(it != nullptr);
+            CPPUNIT_ASSERT(__INTRUSIVE_QUEUE(it) == queue_no_queue);
+            const double v(typ == HEAP_ASC ? __INTRUSIVE_PRIORITY(it) : -__INTRUSIVE_PRIORITY(it));
+            if(!first)
+               CPPUNIT_ASSERT(v >= std::floor(worst / q.get_delta()) * q.get_delta());
+            worst = first ? v : std::max(worst, v);
+            first = false;
+            n++;
+         }
+         CPPUNIT_ASSERT(n == expected);
+         CPPUNIT_ASSERT(q.do_pop() == nullptr);
+      }
+
+      void testFixedWidth(void)
+      {
+         std::vector<item> items(BUCKET_TEST_ITEMS);
+         bucket_queue q(BUCKET_TEST_QUEUE, 2.5);
+         size_t seed(3);
+         for(item& it : items)
+            q.do_insert(&it, random_priority(seed));
+         CPPUNIT_ASSERT(q.size() == BUCKET_TEST_ITEMS);
+         CPPUNIT_ASSERT(q.get_delta() == 2.5);
+         pop_all(q, HEAP_ASC, BUCKET_TEST_ITEMS);
+      }
+
+      void testTunedWidth(void)
+      {
+         std::vector<item> items(BUCKET_TEST_ITEMS);
+         bucket_queue q(BUCKET_TEST_QUEUE);
+         q.set_type(HEAP_DESC);
+         size_t seed(5);
+         double best(0.0);
+         for(item& it : items) {
+            const double prio(random_priority(seed));
+            best = std::max(best, prio);
+            q.do_insert(&it, prio);
+         }
+         CPPUNIT_ASSERT(q.get_delta() == 0.0);
+         // the first pop spreads all nodes over the window.
+         item *top(q.front());
+         CPPUNIT_ASSERT(q.get_delta() > 0.0);
+         CPPUNIT_ASSERT(__INTRUSIVE_PRIORITY(top) >= best - q.get_delta());
+         pop_all(q, HEAP_DESC, BUCKET_TEST_ITEMS);
+      }
+
+      void testMoveAndRemove(void)
+      {
+         std::vector<item> items(BUCKET_TEST_ITEMS);
+         bucket_queue q(BUCKET_TEST_QUEUE, 1.0);
+         for(size_t i(0); i < BUCKET_TEST_ITEMS; ++i)
+            q.do_insert(&items[i], 500.0 + i);
+
+         // below the window.
+         q.do_move_node(&items[10], 3.0);
+         CPPUNIT_ASSERT(q.front() == &items[10]);
+         // far above the window.
+         q.do_move_node(&items[10], 1.0e9);
+         CPPUNIT_ASSERT(q.front() == &items[0]);
+         q.do_remove(&items[0], queue_no_queue);
+         CPPUNIT_ASSERT(__INTRUSIVE_QUEUE(&items[0]) == queue_no_queue);
+         q.do_move_node(&items[0], 1.0);
+         CPPUNIT_ASSERT(q.size() == BUCKET_TEST_ITEMS - 1);
+         CPPUNIT_ASSERT(q.front() == &items[1]);
+         pop_all(q, HEAP_ASC, BUCKET_TEST_ITEMS - 1);
+      }
+
+      void testPopHalf(void)
+      {
+         std::vector<item> items(BUCKET_TEST_ITEMS);
+         std::vector<item*> buffer(BUCKET_TEST_ITEMS);
+         bucket_queue q(BUCKET_TEST_QUEUE, 10.0);
+         // 10 buckets with 100 nodes.
+         for(size_t i(0); i < BUCKET_TEST_ITEMS; ++i)
+            q.do_insert(&items[i], (double)(i % 10) * 10.0);
+
+         const size_t got(q.do_pop_half(&buffer[0], 450, queue_no_queue));
+         // only whole buckets, the worst ones.
+         CPPUNIT_ASSERT(got == 400);
+         for(size_t i(0); i < got; ++i)
+            CPPUNIT_ASSERT(__INTRUSIVE_PRIORITY(buffer[i]) >= 60.0);
+         CPPUNIT_ASSERT(q.size() == BUCKET_TEST_ITEMS - 400);
+
+         // a single bucket is split.
+         std::vector<item> others(BUCKET_TEST_ITEMS);
+         bucket_queue single(BUCKET_TEST_QUEUE, 10.0);
+         for(item& it : others)
+            single.do_insert(&it, 0.0);
+         CPPUNIT_ASSERT(single.do_pop_half(&buffer[0], 1000, queue_no_queue) == 500);
+         CPPUNIT_ASSERT(single.size() == 500);
+      }
+
+      void testExtremePriorities(void)
+      {
+         // keys are clamped, so both ends of the key range are used.
+         const double prios[] = {1.0e300, -INFINITY, 0.0, -5.0, 5.0};
+         const size_t n(sizeof(prios) / sizeof(prios[0]));
+         std::vector<item> items(n);
+         bucket_queue q(BUCKET_TEST_QUEUE, 1.0);
+         q.do_insert(&items[0], prios[0]);
+         // the window starts at the largest key and then moves to the smallest.
+         CPPUNIT_ASSERT(q.front() == &items[0]);
+         for(size_t i(1); i < n; ++i)
+            q.do_insert(&items[i], prios[i]);
+         CPPUNIT_ASSERT(q.size() == n);
+         CPPUNIT_ASSERT(q.front() == &items[1]);
+         pop_all(q, HEAP_ASC, n);
+
+         bucket_queue tuned(BUCKET_TEST_QUEUE);
+         tuned.set_type(HEAP_DESC);
+         for(size_t i(0); i < n; ++i)
+            tuned.do_insert(&items[i], prios[i]);
+         CPPUNIT_ASSERT(tuned.front() == &items[0]);
+         pop_all(tuned, HEAP_DESC, n);
+      }
+
+      CPPUNIT_TEST_SUITE(QueueBucketTests);
+
+      CPPUNIT_TEST(testFixedWidth);
+      CPPUNIT_TEST(testTunedWidth);
+      CPPUNIT_TEST(testMoveAndRemove);
+      CPPUNIT_TEST(testPopHalf);
+      CPPUNIT_TEST(testExtremePriorities);
+      CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(QueueBucketTests);
@@ -19,7 +19,7 @@ public:  											\
       __prev(void): prev(nullptr) {}         \
    } __intrusive_prev;                    \
    queue_id_t __intrusive_queue = queue_no_queue; \
-   utils::byte __intrusive_extra_id
+   utils::byte __intrusive_extra_id = 0
 
 #define __INTRUSIVE_QUEUE(ITEM) ((ITEM)->__intrusive_queue)
 #define __INTRUSIVE_NEXT(ITEM) ((ITEM)->__intrusive_next.next)
@@ -0,0 +1,64 @@
+
+#ifndef QUEUE_PUSH_SAFE_STACK_HPP
+#define QUEUE_PUSH_SAFE_STACK_HPP
+
+#include <atomic>
+#include <assert.h>
+
+namespace queue
+{
+
+// lock-free intrusive stack where multiple threads push
+// and a single thread removes all the elements at once.
+// type T must have a 'next' field of type T*.
+template <class T>
+class push_safe_intrusive_stack
+{
+private:
+
+   std::atomic<T*> head{nullptr};
+
+public:
+
+   inline bool empty(void) const { return head.load() == nullptr; }
+
+   // returns true if the stack was empty before the push.
+   inline bool push(T *item)
+   {
+      T *old(head.load(std::memory_order_relaxed));
+      do {
+         item->next = old;
+      } while(!head.compare_exchange_weak(old, item));
+      return old == nullptr;
+   }
+
+   // removes all the elements and returns them in push order.
+   // only the consumer thread may call this.
+   inline T *pop_all(void)
+   {
+      if(empty())
+         return nullptr;
+
+      T *ls(head.exchange(nullptr));
+      T *ret(nullptr);
+
+      while(ls) {
+         T *next(ls->next);
+         ls->next = ret;
+         ret = ls;
+         ls = next;
+      }
+      return ret;
+   }
+
+   explicit push_safe_intrusive_stack(void) {}
+
+   ~push_safe_intrusive_stack(void)
+   {
+      assert(empty());
+   }
+};
+
+}
+
+#endif
@@ -0,0 +1,290 @@
+
+#ifndef QUEUE_STEALING_DEQUE_HPP
+#define QUEUE_STEALING_DEQUE_HPP
+
+#include <atomic>
+#include <pthread.h>
+#include <vector>
+#include <assert.h>
+
+#include "utils/mutex.hpp"
+#include "queue/intrusive.hpp"
+
+namespace queue
+{
+
+// Chase-Lev work stealing deque of intrusive nodes.
+// The thread that creates the queue owns it and is the only one pushing at the bottom.
+// Nodes pushed by other threads go to an inbox that the owner moves into the deque
+// when it pops. Nodes are popped from the top by the owner and by thieves alike,
+// since popping the most recent node first (as in Chase-Lev) keeps re-scheduling
+// the same nodes and starves programs such as heat transfer.
+// A node belongs to the queue while its intrusive queue id is the queue number
+// and its intrusive position is the index of its entry in the deque, therefore
+// removing a node only changes its id and leaves a stale entry in the deque
+// that is skipped when popped.
+template <class T>
+class intrusive_stealing_deque
+{
+public:
+
+   typedef T* node_type;
+
+private:
+
+   struct buffer {
+      const int64_t capacity;
+      const int64_t mask;
+      std::atomic<T*> *items;
+      // previous (smaller) buffer, only freed with the queue since thieves may still read it.
+      buffer *retired;
+
+      inline T* get(const int64_t i) const { return items[i & mask].load(std::memory_order_relaxed); }
+      inline void put(const int64_t i, T *x) { items[i & mask].store(x, std::memory_order_relaxed); }
+
+      explicit buffer(const int64_t cap, buffer *old):
+         capacity(cap), mask(cap - 1), items(new std::atomic<T*>[cap]), retired(old)
+      {
+      }
+
+      ~buffer(void) { delete []items; }
+   };
+
+   typedef enum {
+      STEAL_OK,
+      STEAL_EMPTY,
+      STEAL_ABORT
+   } steal_result;
+
+#define STEALING_DEQUE_INITIAL_SIZE 1024
+// all threads use the same queue number for their moving queues, therefore
+// positions must also tell which deque a node belongs to. indices of each
+// deque start at a different multiple of this and nodes in the inbox
+// have a negative position that is unique to the deque.
+#define STEALING_DEQUE_INDEX_SPACE ((int64_t)1 << 44)
+
+   static std::atomic<int64_t> num_deques;
+
+   const queue_id_t queue_number;
+   const pthread_t owner;
+   const int64_t deque_number;
+   const int64_t inbox_pos;
+
+   char __pad1[64];
+   std::atomic<int64_t> top;
+   char __pad2[64];
+   std::atomic<int64_t> bottom;
+   std::atomic<buffer*> array;
+   // number of nodes in the queue (stale entries are not counted).
+   std::atomic<size_t> total{0};
+
+   char __pad3[64];
+   utils::mutex inbox_mtx;
+   std::vector<T*> inbox;
+   std::atomic<bool> inbox_pending{false};
+   std::vector<T*> inbox_drain;
+
+   inline bool is_owner(void) const { return pthread_equal(pthread_self(), owner); }
+
+   // moves a node out of the queue, returns false if it was no longer in the queue.
+   inline bool claim(node_type node, const queue_id_t new_state)
+   {
+      if(!__sync_bool_compare_and_swap(&__INTRUSIVE_QUEUE(node), queue_number, new_state))
+         return false;
+      LOG_NORMAL_OPERATION();
+      total--;
+      return true;
+   }
+
+   buffer *grow(buffer *a, const int64_t b, const int64_t t)
+   {
+      buffer *n(new buffer(a->capacity * 2, a));
+      for(int64_t i(t); i < b; ++i)
+         n->put(i, a->get(i));
+      array.store(n, std::memory_order_release);
+      return n;
+   }
+
+   // owner only. the node position must already be the current bottom.
+   inline void push_bottom(node_type node)
+   {
+      const int64_t b(bottom.load(std::memory_order_relaxed));
+      const int64_t t(top.load(std::memory_order_acquire));
+      buffer *a(array.load(std::memory_order_relaxed));
+
+      if(b - t > a->capacity - 1)
+         a = grow(a, b, t);
+      a->put(b, node);
+      std::atomic_thread_fence(std::memory_order_release);
+      bottom.store(b + 1, std::memory_order_relaxed);
+   }
+
+   // takes the entry at the top. entries of nodes that were removed
+   // or pushed again at another position are returned as null.
+   inline steal_result steal(node_type& x)
+   {
+      int64_t t(top.load(std::memory_order_acquire));
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      const int64_t b(bottom.load(std::memory_order_acquire));
+
+      if(t >= b)
+         return STEAL_EMPTY;
+
+      buffer *a(array.load(std::memory_order_acquire));
+      x = a->get(t);
+      const int64_t index(t);
+      if(!top.compare_exchange_strong(t, t + 1,
+               std::memory_order_seq_cst, std::memory_order_relaxed))
+         return STEAL_ABORT;
+      if(!in_queue(x) || __INTRUSIVE_POS(x) != index)
+         x = nullptr;
+      return STEAL_OK;
+   }
+
+   void drain_inbox(void)
+   {
+      {
+         MUTEX_LOCK_GUARD(inbox_mtx, normal_lock);
+         inbox_drain.swap(inbox);
+         inbox_pending.store(false, std::memory_order_relaxed);
+      }
+      for(node_type node : inbox_drain) {
+         // the node may have been removed and put into another queue that uses
+         // the position field, or pushed again and already drained.
+         const int64_t b(bottom.load(std::memory_order_relaxed));
+         if(__sync_bool_compare_and_swap(&__INTRUSIVE_POS(node), inbox_pos, b))
+            push_bottom(node);
+      }
+      inbox_drain.clear();
+   }
+
+public:
+
+   inline size_t size(void) const { return total.load(std::memory_order_relaxed); }
+   inline bool empty(void) const { return size() == 0; }
+
+   inline bool in_queue(node_type node) const
+   {
+      return __INTRUSIVE_QUEUE(node) == queue_number;
+   }
+
+   inline void push_tail(node_type node LOCKING_STAT_FLAG)
+   {
+      assert(__INTRUSIVE_QUEUE(node) != queue_number);
+      const bool owned(is_owner());
+
+      total++;
+      // set the position before the node joins the queue so that stale entries
+      // cannot claim it. nodes in the inbox do not have an entry yet.
+      __INTRUSIVE_POS(node) = owned ? bottom.load(std::memory_order_relaxed) : inbox_pos;
+      __INTRUSIVE_QUEUE(node) = queue_number;
+
+      if(owned) {
+         LOG_NORMAL_OPERATION();
+         push_bottom(node);
+         return;
+      }
+
+      MUTEX_LOCK_GUARD_FLAG(inbox_mtx, normal_lock, coord_normal_lock);
+      inbox.push_back(node);
+      inbox_pending.store(true, std::memory_order_release);
+   }
+
+   // pops the oldest node.
+   inline bool pop_head(node_type& data, const queue_id_t new_state)
+   {
+      const bool owned(is_owner());
+
+      if(owned && inbox_pending.load(std::memory_order_acquire))
+         drain_inbox();
+
+      while(!empty()) {
+         node_type node(nullptr);
+         switch(steal(node)) {
+            case STEAL_EMPTY:
+               if(!owned || !inbox_pending.load(std::memory_order_acquire))
+                  return false;
+               drain_inbox();
+               break;
+            case STEAL_ABORT:
+               break;
+            case STEAL_OK:
+               if(node && claim(node, new_state)) {
+                  data = node;
+                  return true;
+               }
+               break;
+         }
+      }
+      return false;
+   }
+
+   // steals one node.
+   inline bool pop_tail(node_type& data, const queue_id_t new_state)
+   {
+      node_type *buf(&data);
+      return pop_tail_half(buf, 1, new_state) == 1;
+   }
+
+   // steals up to half of the nodes in the queue, but no more than 'max'.
+   inline size_t pop_tail_half(node_type *buf, const size_t max, const queue_id_t new_state)
+   {
+      const size_t half(max == 1 ? (size_t)!empty() : std::min(max, size() / 2));
+      size_t stolen(0);
+
+      // stale entries and lost races count as attempts so that thieves give up eventually.
+      for(size_t attempts(0); stolen < half && attempts < 2 * max + 4; ++attempts) {
+         node_type x(nullptr);
+         const steal_result r(steal(x));
+         if(r == STEAL_EMPTY)
+            break;
+         if(r == STEAL_ABORT)
+            continue;
+         if(x && claim(x, new_state))
+            buf[stolen++] = x;
+      }
+      return stolen;
+   }
+
+   inline bool do_remove(node_type node, const queue_id_t new_state)
+   {
+      return claim(node, new_state);
+   }
+
+   inline bool remove(node_type node, const queue_id_t new_state LOCKING_STAT_FLAG)
+   {
+#ifdef LOCK_STATISTICS
+      (void)lock_stat_use1;
+#endif
+      return claim(node, new_state);
+   }
+
+   explicit intrusive_stealing_deque(const queue_id_t id):
+      queue_number(id), owner(pthread_self()),
+      deque_number(num_deques++), inbox_pos(-(deque_number + 1)),
+      array(new buffer(STEALING_DEQUE_INITIAL_SIZE, nullptr))
+   {
+      top.store(deque_number * STEALING_DEQUE_INDEX_SPACE);
+      bottom.store(deque_number * STEALING_DEQUE_INDEX_SPACE);
+   }
+
+   intrusive_stealing_deque(const intrusive_stealing_deque&) = delete;
+   intrusive_stealing_deque& operator=(const intrusive_stealing_deque&) = delete;
+
+   ~intrusive_stealing_deque(void)
+   {
+      buffer *a(array.load());
+      while(a) {
+         buffer *old(a->retired);
+         delete a;
+         a = old;
+      }
+   }
+};
+
+template <class T>
+std::atomic<int64_t> intrusive_stealing_deque<T>::num_deques(0);
+
+}
+
+#endif
@@ -11,7 +11,7 @@ struct array
 {
    private:
 
-      std::atomic<vm::ref_count> refs{0};
+      ref_counter refs;
       size_t cap;
       size_t size;
       vm::tuple_field *elems;
@@ -37,13 +37,12 @@ struct array
 
       inline void inc_refs(void)
       {
-         refs++;
+         refs.inc();
       }
 
       inline void dec_refs(vm::type *type, vm::candidate_gc_nodes& gc_nodes)
       {
-         assert(refs > 0);
-         if(--refs == 0)
+         if(refs.dec(this, vm::FIELD_ARRAY, type))
             destroy(type, gc_nodes);
       }
 
@@ -84,7 +83,8 @@ struct array
       static inline array* create_empty(const size_t init_cap = 8, const size_t start_refs = 0)
       {
          array *a(mem::allocator<array>().allocate(1));
-         a->refs = start_refs;
+         mem::allocator<array>().construct(a);
+         a->refs.set(start_refs);
          a->cap = init_cap;
          a->size = 0;
          a->elems = mem::allocator<vm::tuple_field>().allocate(a->cap);
@@ -94,7 +94,8 @@ struct array
       static inline array* create_fill(vm::type *t, const size_t size, const vm::tuple_field f, const size_t start_refs = 0)
       {
          array *a(mem::allocator<array>().allocate(1));
-         a->refs = start_refs;
+         mem::allocator<array>().construct(a);
+         a->refs.set(start_refs);
          a->cap = size * 2;
          a->size = size;
          a->elems = mem::allocator<vm::tuple_field>().allocate(a->cap);
@@ -110,7 +111,8 @@ struct array
       static inline array* create_from_vector(vm::type *t, const std::vector<vm::tuple_field, mem::allocator<vm::tuple_field>>& v, const size_t start_refs = 0)
       {
          array *a(mem::allocator<array>().allocate(1));
-         a->refs = start_refs;
+         mem::allocator<array>().construct(a);
+         a->refs.set(start_refs);
          a->cap = v.size() * 2;
          a->size = v.size();
          a->elems = mem::allocator<vm::tuple_field>().allocate(a->cap);
@@ -126,7 +128,8 @@ struct array
       static inline array* mutate(const array *old, vm::type *type, const size_t idx, const vm::tuple_field f, const size_t start_refs = 0)
       {
          array *a(mem::allocator<array>().allocate(1));
-         a->refs = start_refs;
+         mem::allocator<array>().construct(a);
+         a->refs.set(start_refs);
          a->cap = old->cap;
          a->size = old->size;
          a->elems = mem::allocator<vm::tuple_field>().allocate(old->cap);
@@ -142,7 +145,8 @@ struct array
       static inline array* mutate_add(const array *old, vm::type *type, const vm::tuple_field f, const size_t start_refs = 0)
       {
          array *a(mem::allocator<array>().allocate(1));
-         a->refs = start_refs;
+         mem::allocator<array>().construct(a);
+         a->refs.set(start_refs);
          if(old->size == old->cap)
             a->cap = 2 * old->cap;
          else
@@ -20,7 +20,7 @@ struct cons
 
    private:
 
-      std::atomic<vm::ref_count> refs{0};
+      ref_counter refs;
       list_ptr tail{nullptr};
       vm::tuple_field head;
 
@@ -39,13 +39,12 @@ struct cons
 
       inline void inc_refs(void)
       {
-         refs++;
+         refs.inc();
       }
 
       inline void dec_refs(vm::list_type *type, vm::candidate_gc_nodes& gc_nodes)
       {
-         assert(refs > 0);
-         if(--refs == 0)
+         if(refs.dec(this, vm::FIELD_LIST, type))
             destroy(type, gc_nodes);
       }
 
@@ -53,7 +52,7 @@ struct cons
       {
          if(is_null(ls))
             return true;
-         return ls->refs > 0;
+         return ls->refs.get() > 0;
       }
 
       inline void destroy(vm::list_type *type, vm::candidate_gc_nodes& gc_nodes)
@@ -247,7 +246,7 @@ struct cons
       {
          cons *c((cons*)mem::center::allocate_cons(sizeof(cons)));
          mem::allocator<cons>().construct(c);
-         c->refs = start_refs;
+         c->refs.set(start_refs);
          c->head = _head;
          c->set_tail(_tail);
          increment_runtime_data(c->head, _type->get_type());
@@ -1,3 +1,5 @@
+#include <mutex>
+#include <vector>
 
 #include "db/node.hpp"
 #include "db/database.hpp"
@@ -10,6 +12,127 @@ using namespace db;
 namespace runtime
 {
 
+__thread uint32_t current_owner{0};
+bool owners_stopped{false};
+
+// objects waiting for their owner to merge the reference counts.
+struct pending_merge
+{
+   void *obj;
+   field_type kind;
+   vm::type *type;
+};
+
+struct owner_queue
+{
+   std::mutex lock;
+   std::vector<pending_merge> items;
+};
+
+static owner_queue *owner_queues{nullptr};
+static size_t num_owners{0};
+
+static inline void
+destroy_object(void *p, const field_type kind, vm::type *t, candidate_gc_nodes& gc_nodes)
+{
+   switch(kind) {
+      case FIELD_LIST: ((runtime::cons*)p)->destroy((list_type*)t, gc_nodes); break;
+      case FIELD_STRUCT: ((runtime::struct1*)p)->destroy((struct_type*)t, gc_nodes); break;
+      case FIELD_ARRAY: ((runtime::array*)p)->destroy(t, gc_nodes); break;
+      case FIELD_SET: ((runtime::set*)p)->destroy(t, gc_nodes); break;
+      case FIELD_STRING: ((runtime::rstring*)p)->destroy(); break;
+      default: abort(); break;
+   }
+}
+
+void
+release_object(void *p, const field_type kind, vm::type *t, candidate_gc_nodes& gc_nodes)
+{
+   assert(p != nullptr);
+   switch(kind) {
+      case FIELD_LIST: ((runtime::cons*)p)->dec_refs((list_type*)t, gc_nodes); break;
+      case FIELD_STRUCT: ((runtime::struct1*)p)->dec_refs((struct_type*)t, gc_nodes); break;
+      case FIELD_ARRAY: ((runtime::array*)p)->dec_refs(t, gc_nodes); break;
+      case FIELD_SET: ((runtime::set*)p)->dec_refs(t, gc_nodes); break;
+      case FIELD_STRING: ((runtime::rstring*)p)->dec_refs(); break;
+      default: abort(); break;
+   }
+}
+
+void
+init_owners(const size_t num_threads)
+{
+   delete []owner_queues;
+   num_owners = num_threads;
+   owner_queues = new owner_queue[num_threads];
+   owners_stopped = false;
+}
+
+void
+set_current_owner(const uint32_t owner)
+{
+   current_owner = owner;
+}
+
+void
+defer_merge(const uint32_t owner, void *obj, const field_type kind, vm::type *t)
+{
+   assert(owner > 0 && owner <= num_owners);
+   owner_queue& q(owner_queues[owner - 1]);
+   std::lock_guard<std::mutex> l(q.lock);
+   q.items.push_back({obj, kind, t});
+}
+
+static inline bool
+merge_queue(owner_queue& q, candidate_gc_nodes& gc_nodes)
+{
+   std::vector<pending_merge> items;
+   {
+      std::lock_guard<std::mutex> l(q.lock);
+      if(q.items.empty())
+         return false;
+      items.swap(q.items);
+   }
+   for(pending_merge& m : items) {
+      if(((ref_base*)m.obj)->refs.merge(true))
+         destroy_object(m.obj, m.kind, m.type, gc_nodes);
+   }
+   return true;
+}
+
+void
+merge_pending(candidate_gc_nodes& gc_nodes)
+{
+   if(current_owner == 0)
+      return;
+   merge_queue(owner_queues[current_owner - 1], gc_nodes);
+}
+
+// called once the scheduler threads are gone, so we can merge for them.
+// destroying objects may queue more objects.
+void
+merge_all_pending(candidate_gc_nodes& gc_nodes)
+{
+   bool again(true);
+   while(again) {
+      again = false;
+      for(size_t i(0); i < num_owners; ++i)
+         again = merge_queue(owner_queues[i], gc_nodes) || again;
+   }
+}
+
+// called once the scheduler threads are gone.
+// objects dropped after this point are merged right away.
+void
+stop_owners(candidate_gc_nodes& gc_nodes)
+{
+   owners_stopped = true;
+   merge_all_pending(gc_nodes);
+   delete []owner_queues;
+   owner_queues = nullptr;
+   num_owners = 0;
+}
+
 void
 do_increment_runtime(const vm::tuple_field& f, const vm::field_type t)
 {
@@ -20,9 +143,9 @@ do_increment_runtime(const vm::tuple_field& f, const vm::field_type t)
    if(t == FIELD_NODE) {
       db::node *node((db::node*)FIELD_NODE(f));
       if(!All->DATABASE->is_initial_node(node))
-         p->refs++;
+         node->refs++;
    } else
-      p->refs++;
+      p->refs.inc();
 }
 
 void
@@ -37,33 +160,19 @@ do_decrement_runtime(const vm::tuple_field& f, const vm::type *t, candidate_gc_n
 
    switch(t->get_type()) {
       case FIELD_LIST:
-         assert(p->refs > 0);
-         if(--(p->refs) == 0)
-            ((runtime::cons*)p)->destroy((list_type*)t, gc_nodes);
+         ((runtime::cons*)p)->dec_refs((list_type*)t, gc_nodes);
          break;
       case FIELD_STRUCT:
-         assert(p->refs > 0);
-         if(--(p->refs) == 0)
-            ((runtime::struct1*)p)->destroy((struct_type*)t, gc_nodes);
+         ((runtime::struct1*)p)->dec_refs((struct_type*)t, gc_nodes);
          break;
       case FIELD_ARRAY:
-         assert(p->refs > 0);
-         if(--(p->refs) == 0) {
-            array_type *tt((array_type*)t);
-            ((runtime::array*)p)->destroy(tt->get_base(), gc_nodes);
-         }
+         ((runtime::array*)p)->dec_refs(((array_type*)t)->get_base(), gc_nodes);
          break;
       case FIELD_SET:
-         assert(p->refs > 0);
-         if(--(p->refs) == 0) {
-            set_type *tt((set_type*)t);
-            ((runtime::set*)p)->destroy(tt->get_base(), gc_nodes);
-         }
+         ((runtime::set*)p)->dec_refs(((set_type*)t)->get_base(), gc_nodes);
          break;
       case FIELD_STRING:
-         assert(p->refs > 0);
-         if(--(p->refs) == 0)
-            ((runtime::rstring*)p)->destroy();
+         ((runtime::rstring*)p)->dec_refs();
          break;
       case FIELD_NODE:
 #ifdef GC_NODES
@@ -22,6 +22,16 @@ namespace runtime {
 void do_increment_runtime(const vm::tuple_field&, const vm::field_type);
 void do_decrement_runtime(const vm::tuple_field&, const vm::type*, vm::candidate_gc_nodes&);
 
+// biased reference counting, see runtime/ref_base.hpp.
+void init_owners(const size_t);
+void set_current_owner(const uint32_t);
+void merge_pending(vm::candidate_gc_nodes&);
+void merge_all_pending(vm::candidate_gc_nodes&);
+void stop_owners(vm::candidate_gc_nodes&);
+
+// drops a reference to an object given its kind and the type used by dec_refs.
+void release_object(void *, const vm::field_type, vm::type *, vm::candidate_gc_nodes&);
+
 inline void increment_runtime_data(const vm::tuple_field& f, const vm::field_type t)
 {
    switch(t) {
@@ -1,20 +1,147 @@
-
 #ifndef RUNTIME_REF_BASE_HPP
 #define RUNTIME_REF_BASE_HPP
 
 #include <atomic>
+#include <cstdint>
+#include <assert.h>
 
 #include "vm/defs.hpp"
 #include "mem/base.hpp"
+#include "vm/types.hpp"
 
 namespace runtime
 {
 
+// owner id of the running scheduler thread (thread id + 1).
+// zero means that the thread does not own objects.
+extern __thread uint32_t current_owner;
+
+// set once the scheduler threads are gone. nobody looks at their queues
+// anymore, so objects still biased to them are merged by the last user.
+extern bool owners_stopped;
+
+// queues the object so that its owner merges the reference counts.
+void defer_merge(const uint32_t, void *, const vm::field_type, vm::type *);
+
+// Biased reference counter (Choi et al., 2018).
+// The thread that created the object counts its references in 'biased'
+// without atomic operations. Other threads use the atomic 'shared'
+// counter, which may become negative while the owner still holds biased
+// references. When the biased count reaches zero the owner merges both
+// counters and from then on every thread uses the shared counter.
+// If another thread finds the shared counter at or below zero before
+// the merge, the object is queued and the owner merges it later.
+struct ref_counter
+{
+private:
+
+// 'shared' keeps the count in the high bits and the flags in the low bits.
+#define REF_MERGED ((uint64_t)1)
+#define REF_QUEUED ((uint64_t)2)
+#define REF_FLAGS (REF_MERGED | REF_QUEUED)
+#define REF_ONE ((uint64_t)4)
+#define REF_BIASED_MERGED UINT32_MAX
+
+   uint32_t owner;
+   uint32_t biased;
+   std::atomic<uint64_t> shared;
+
+   static inline int64_t count(const uint64_t x) { return (int64_t)(x & ~REF_FLAGS) / (int64_t)REF_ONE; }
+
+   inline bool owned(void) const
+   {
+      return owner == current_owner && biased != REF_BIASED_MERGED;
+   }
+
+public:
+
+   // gives up the biased count. returns true if the object is dead.
+   // 'pending' is set when the merge comes from the queue of the owner.
+   inline bool merge(const bool pending = false)
+   {
+      const uint64_t add(biased == REF_BIASED_MERGED ? 0 : (uint64_t)biased * REF_ONE);
+      biased = REF_BIASED_MERGED;
+      uint64_t old(shared.load()), next;
+      do {
+         next = (old + add) | REF_MERGED;
+         if(pending)
+            next &= ~REF_QUEUED;
+      } while(!shared.compare_exchange_weak(old, next));
+      // while queued, the object is destroyed when the queue is processed.
+      return count(next) == 0 && !(next & REF_QUEUED);
+   }
+
+   // approximate when called outside the owner thread.
+   inline int64_t get(void) const
+   {
+      return (biased == REF_BIASED_MERGED ? 0 : (int64_t)biased) + count(shared.load());
+   }
+
+   // sets the references of a new object.
+   inline void set(const vm::ref_count n)
+   {
+      if(owned())
+         biased = n;
+      else
+         shared = (shared.load() & REF_FLAGS) + n * REF_ONE;
+   }
+
+   inline void inc(void)
+   {
+      if(owned())
+         biased++;
+      else
+         shared.fetch_add(REF_ONE, std::memory_order_relaxed);
+   }
+
+   // returns true if the caller must destroy the object.
+   // kind and type are the ones needed to destroy the object.
+   inline bool dec(void *obj, const vm::field_type kind, vm::type *t)
+   {
+      if(owned()) {
+         if(biased > 0) {
+            if(--biased > 0)
+               return false;
+         } else
+            shared.fetch_sub(REF_ONE);
+         return merge();
+      }
+
+      const uint64_t next(shared.fetch_sub(REF_ONE) - REF_ONE);
+      if(next & REF_MERGED)
+         return count(next) == 0 && !(next & REF_QUEUED);
+      if(count(next) > 0 || (next & REF_QUEUED))
+         return false;
+      if(owners_stopped)
+         return merge();
+      // only the owner knows how many biased references remain.
+      uint64_t old(next);
+      while(!(old & REF_FLAGS)) {
+         if(shared.compare_exchange_weak(old, old | REF_QUEUED)) {
+            defer_merge(owner, obj, kind, t);
+            return false;
+         }
+      }
+      // the owner merged in the meantime and saw our decrement.
+      return false;
+   }
+
+   explicit ref_counter(void):
+      owner(current_owner), biased(0), shared(0)
+   {
+      // objects created outside the scheduler threads are always shared.
+      if(owner == 0) {
+         biased = REF_BIASED_MERGED;
+         shared = REF_MERGED;
+      }
+   }
+};
+
 /* we assume that reference types (lists, structs, strings) have a reference counter at the beginning of the memory object */
 struct ref_base
 {
 public:
-	std::atomic<vm::ref_count> refs;
+	ref_counter refs;
 };
 
 };
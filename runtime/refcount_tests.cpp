@@ -0,0 +1,179 @@
+
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+
+#include "runtime/objs.hpp"
+
+class RuntimeRefcountTests : public TestFixture {
+   public:
+
+#define REFCOUNT_BENCH_OPS 2000000
+
+      void setUp(void)
+      {
+         runtime::init_owners(2);
+         runtime::set_current_owner(1);
+      }
+
+      void tearDown(void)
+      {
+         runtime::set_current_owner(0);
+      }
+
+      void testOwner(void)
+      {
+         runtime::ref_counter c;
+         c.set(1);
+         c.inc();
+         c.inc();
+         CPPUNIT_ASSERT(c.get() == 3);
+         CPPUNIT_ASSERT(!c.dec(nullptr, vm::FIELD_STRING, nullptr));
+         CPPUNIT_ASSERT(!c.dec(nullptr, vm::FIELD_STRING, nullptr));
+         CPPUNIT_ASSERT(c.dec(nullptr, vm::FIELD_STRING, nullptr));
+      }
+
+      void testShared(void)
+      {
+         runtime::set_current_owner(0);
+         runtime::ref_counter c;
+         c.set(1);
+         c.inc();
+         CPPUNIT_ASSERT(c.get() == 2);
+         CPPUNIT_ASSERT(!c.dec(nullptr, vm::FIELD_STRING, nullptr));
+         CPPUNIT_ASSERT(c.dec(nullptr, vm::FIELD_STRING, nullptr));
+      }
+
+      void testOwnerMergesFirst(void)
+      {
+         runtime::ref_counter c;
+         c.set(1);
+         std::thread t([&c]() {
+            runtime::set_current_owner(2);
+            c.inc();
+         });
+         t.join();
+         // the owner drops its reference and gives up the bias.
+         CPPUNIT_ASSERT(!c.dec(nullptr, vm::FIELD_STRING, nullptr));
+         CPPUNIT_ASSERT(c.get() == 1);
+         bool dead(false);
+         std::thread t2([&c, &dead]() {
+            runtime::set_current_owner(2);
+            dead = c.dec(nullptr, vm::FIELD_STRING, nullptr);
+         });
+         t2.join();
+         CPPUNIT_ASSERT(dead);
+      }
+
+      void testDeferredMerge(void)
+      {
+         runtime::rstring *s(runtime::rstring::make_default_string("deferred"));
+         // the string is moved to another thread, which drops it.
+         std::thread t([s]() {
+            runtime::set_current_owner(2);
+            s->dec_refs();
+         });
+         t.join();
+         CPPUNIT_ASSERT(!s->has_refs());
+         vm::candidate_gc_nodes gc_nodes;
+         runtime::merge_pending(gc_nodes);
+         // nothing is left in the queue.
+         runtime::merge_all_pending(gc_nodes);
+      }
+
+      void testStoppedOwner(void)
+      {
+         runtime::ref_counter c;
+         c.set(1);
+         c.inc();
+         // the owner thread is gone while it still holds biased references.
+         vm::candidate_gc_nodes gc_nodes;
+         runtime::stop_owners(gc_nodes);
+         runtime::set_current_owner(0);
+         CPPUNIT_ASSERT(!c.dec(nullptr, vm::FIELD_STRING, nullptr));
+         CPPUNIT_ASSERT(c.dec(nullptr, vm::FIELD_STRING, nullptr));
+      }
+
+      // compares the cost of a reference count update with an atomic
+      // counter against the biased counter, first in the owner thread
+      // and then while another thread also touches the object.
+      void testRefcountTraffic(void)
+      {
+         std::atomic<vm::ref_count> atomic_refs{1};
+         runtime::ref_counter biased;
+         biased.set(1);
+
+         auto start(std::chrono::steady_clock::now());
+         for(size_t i(0); i < REFCOUNT_BENCH_OPS; ++i) {
+            atomic_refs++;
+            --atomic_refs;
+         }
+         auto atomic_done(std::chrono::steady_clock::now());
+         for(size_t i(0); i < REFCOUNT_BENCH_OPS; ++i) {
+            biased.inc();
+            CPPUNIT_ASSERT(!biased.dec(nullptr, vm::FIELD_STRING, nullptr));
+         }
+         auto biased_done(std::chrono::steady_clock::now());
+         CPPUNIT_ASSERT(atomic_refs == 1);
+         CPPUNIT_ASSERT(biased.get() == 1);
+
+         auto remote_atomic = [&atomic_refs]() {
+            for(size_t i(0); i < REFCOUNT_BENCH_OPS; ++i) {
+               atomic_refs++;
+               --atomic_refs;
+            }
+         };
+         auto shared_start(std::chrono::steady_clock::now());
+         std::thread t(remote_atomic);
+         for(size_t i(0); i < REFCOUNT_BENCH_OPS; ++i) {
+            atomic_refs++;
+            --atomic_refs;
+         }
+         t.join();
+         auto shared_atomic_done(std::chrono::steady_clock::now());
+
+         // the remote thread holds a reference so the shared count
+         // never reaches zero and the object is never queued.
+         auto remote_biased = [&biased]() {
+            runtime::set_current_owner(2);
+            biased.inc();
+            for(size_t i(0); i < REFCOUNT_BENCH_OPS; ++i) {
+               biased.inc();
+               biased.dec(nullptr, vm::FIELD_STRING, nullptr);
+            }
+         };
+         std::thread t2(remote_biased);
+         for(size_t i(0); i < REFCOUNT_BENCH_OPS; ++i) {
+            biased.inc();
+            CPPUNIT_ASSERT(!biased.dec(nullptr, vm::FIELD_STRING, nullptr));
+         }
+         t2.join();
+         auto shared_biased_done(std::chrono::steady_clock::now());
+         CPPUNIT_ASSERT(atomic_refs == 1);
+         CPPUNIT_ASSERT(biased.get() == 2);
+
+         auto ms = [](const std::chrono::steady_clock::time_point a,
+               const std::chrono::steady_clock::time_point b) {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(b - a).count();
+         };
+         std::cout << std::endl << "refcount: " << REFCOUNT_BENCH_OPS
+            << " inc/dec pairs, one thread: atomic " << ms(start, atomic_done)
+            << "ms, biased " << ms(atomic_done, biased_done)
+            << "ms, two threads: atomic " << ms(biased_done, shared_atomic_done)
+            << "ms, biased " << ms(shared_atomic_done, shared_biased_done)
+            << "ms" << std::endl;
+      }
+
+      CPPUNIT_TEST_SUITE(RuntimeRefcountTests);
+
+      CPPUNIT_TEST(testOwner);
+      CPPUNIT_TEST(testShared);
+      CPPUNIT_TEST(testOwnerMergesFirst);
+      CPPUNIT_TEST(testDeferredMerge);
+      CPPUNIT_TEST(testStoppedOwner);
+      CPPUNIT_TEST(testRefcountTraffic);
+      CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RuntimeRefcountTests);
@@ -12,7 +12,7 @@ struct set
 {
    private:
 
-      std::atomic<vm::ref_count> refs{0};
+      ref_counter refs;
       using hash_type = vm::ptr_val;
       static_assert(sizeof(hash_type) == sizeof(vm::tuple_field), "hash_type must be as long as vm::tuple_field.");
 //      using data_type = std::unordered_set<hash_type, utils::fnv1_hasher<hash_type>,
@@ -47,7 +47,7 @@ struct set
 
       inline void inc_refs(void)
       {
-         refs++;
+         refs.inc();
       }
 
       iterator begin() { return data.begin(); }
@@ -57,8 +57,7 @@ struct set
 
       inline void dec_refs(vm::type *type, vm::candidate_gc_nodes& gc_nodes)
       {
-         assert(refs > 0);
-         if(--refs == 0)
+         if(refs.dec(this, vm::FIELD_SET, type))
             destroy(type, gc_nodes);
       }
 
@@ -83,14 +82,14 @@ struct set
       static inline set* create_empty(const size_t start_refs = 0)
       {
          set *a(create());
-         a->refs = start_refs;
+         a->refs.set(start_refs);
          return a;
       }
 
       static inline set* create_from_vector(vm::type *t, const std::vector<vm::tuple_field, mem::allocator<vm::tuple_field>>& v, const size_t start_refs = 0)
       {
          set *a(create());
-         a->refs = start_refs;
+         a->refs.set(start_refs);
          if(t->is_reference()) {
             for(const vm::tuple_field& f : v) 
                a->add(f, t);
@@ -101,7 +100,7 @@ struct set
       static inline set* mutate_add(const set *old, vm::type *type, const vm::tuple_field f, const size_t start_refs = 0)
       {
          set *a(create());
-         a->refs = start_refs;
+         a->refs.set(start_refs);
          a->data = old->data;
          a->add(f, type);
          //std::cout << a->data.bucket_count() << "/" << a->data.max_bucket_count() << std::endl;
@@ -12,20 +12,19 @@ public:
 	
 private:
 	
-	std::atomic<vm::ref_count> refs;
+	ref_counter refs;
 	std::string content;
 	
 public:
 	
 	inline void inc_refs(void)
 	{
-		refs++;
+		refs.inc();
 	}
 	
 	inline void dec_refs(void)
 	{
-		assert(refs > 0);
-		if(--refs == 0)
+		if(refs.dec(this, vm::FIELD_STRING, nullptr))
          destroy();
 	}
 	
@@ -36,7 +35,7 @@ public:
 	
    inline bool has_refs(void) const
    {
-      return refs > 0;
+      return refs.get() > 0;
    }
 	
 	inline std::string get_content(void) const
@@ -56,7 +55,7 @@ public:
       rstring_ptr p = mem::allocator<rstring>().allocate(1);
       mem::allocator<rstring>().construct(p);
       p->content = str;
-      p->refs = 1;
+      p->refs.set(1);
 		return p;
 	}
 	
@@ -74,8 +73,7 @@ public:
       mem::allocator<rstring>().deallocate(p, 1);
    }
 
-	explicit rstring():
-      refs(0)
+	explicit rstring()
 	{
 	}
 };
@@ -12,7 +12,7 @@
 
 struct struct1 {
    private:
-   std::atomic<vm::ref_count> refs;
+   ref_counter refs;
 
    inline vm::tuple_field *get_fields(void) {
       return (vm::tuple_field *)(this + 1);
@@ -22,12 +22,11 @@ struct struct1 {
    }
 
    public:
-   inline void inc_refs(void) { refs++; }
+   inline void inc_refs(void) { refs.inc(); }
 
    inline void dec_refs(vm::struct_type *typ,
                         vm::candidate_gc_nodes &gc_nodes) {
-      assert(refs > 0);
-      if (--refs == 0) destroy(typ, gc_nodes);
+      if (refs.dec(this, vm::FIELD_STRUCT, typ)) destroy(typ, gc_nodes);
    }
 
    inline void destroy(vm::struct_type *typ, vm::candidate_gc_nodes &gc_nodes) {
@@ -63,5 +62,5 @@ struct struct1 {
       mem::allocator<utils::byte>().deallocate((utils::byte *)p, size);
    }
 
-   struct1(void) : refs(0) {}
+   struct1(void) {}
 };
@@ -30,6 +30,13 @@ struct slice
    size_t node_lock_ok = 0;
    size_t node_lock_fail = 0;
    int32_t node_difference = 0;
+   size_t priority_pops = 0;
+   size_t priority_inversions = 0;
+   size_t priority_stale = 0;
+   size_t parks = 0;
+   size_t wakeups = 0;
+   size_t wakeup_latency = 0;
+   int64_t cpu_time = 0;
 };
 
 }
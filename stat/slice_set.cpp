@@ -57,6 +57,20 @@ slice_set::write(const string& file, vm::all *all) const
          [](const slice& sl) { return sl.all_transactions; });
    write_general(file + ".node_difference", "node_difference", all,
          [](const slice& sl) { return sl.node_difference; });
+   write_general(file + ".priority_pops", "prioritypops", all,
+         [](const slice& sl) { return sl.priority_pops; });
+   write_general(file + ".priority_inversions", "priorityinversions", all,
+         [](const slice& sl) { return sl.priority_inversions; });
+   write_general(file + ".priority_stale", "prioritystale", all,
+         [](const slice& sl) { return sl.priority_stale; });
+   write_general(file + ".parks", "parks", all,
+         [](const slice& sl) { return sl.parks; });
+   write_general(file + ".wakeups", "wakeups", all,
+         [](const slice& sl) { return sl.wakeups; });
+   write_general(file + ".wakeup_latency", "wakeuplatency", all,
+         [](const slice& sl) { return sl.wakeup_latency; });
+   write_general(file + ".cpu_time", "cputime", all,
+         [](const slice& sl) { return sl.cpu_time; });
 }
    
 void
@@ -32,6 +32,7 @@ static void help(void) {
    help_schedulers();
    cerr << "\t-n \t\tno dynamic scheduling" << endl;
    cerr << "\t-w \t\tdisable work stealing" << endl;
+   cerr << "\t-a \t\tpin threads to cores (NUMA aware)" << endl;
    cerr << "\t-t \t\ttime execution" << endl;
 #ifdef INSTRUMENTATION
    cerr << "\t-i <file>\tdump time statistics" << endl;
@@ -83,6 +84,9 @@ static vm::machine_arguments read_arguments(int argc, char** argv) {
          case 'w':
             work_stealing = false;
             break;
+         case 'a':
+            pin_threads = true;
+            break;
          case 'h':
             help();
             break;
@@ -148,6 +148,11 @@ if [ "${TYPE}" = "thread" ]; then
 	exit $?
 fi
 
+if [ "${TYPE}" = "relaxed" ]; then
+	loop_sched thm ${RUNS}
+	exit $?
+fi
+
 if [ "${TYPE}" = "serial" ]; then
    run_serial_n th1 ${RUNS}
 	exit $?
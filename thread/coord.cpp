@@ -406,12 +406,46 @@ thread::move_node_to_new_owner(db::node *tn, thread *new_owner)
    comm_threads.set_bit(new_owner->get_id());
 }
 
+void
+thread::check_node_placement(db::node *tn)
+{
+   if(tn->comm_samples < THREAD_PLACEMENT_SAMPLES)
+      return;
+
+   thread *target(tn->comm_candidate);
+   // the candidate that survives with this many votes got at least 5/8
+   // of the facts sent by the node.
+   const bool remote(target != this && tn->comm_votes * 4 >= tn->comm_samples);
+   tn->comm_candidate = nullptr;
+   tn->comm_votes = 0;
+   tn->comm_samples = 0;
+   // ownership stays fixed under BSP and placement directives win.
+   if(!node_migration || bsp_mode || tn->placed || tn->get_static() != this)
+      return;
+
+   uint64_t total(0);
+   thread *lightest(this);
+   for(size_t i(0); i < All->NUM_THREADS; ++i) {
+      thread *other(All->SCHEDS[i]);
+      total += other->num_static_nodes();
+      if(other->num_static_nodes() < lightest->num_static_nodes())
+         lightest = other;
+   }
+   const uint64_t limit(total * (100 + THREAD_STATIC_IMBALANCE) / (100 * All->NUM_THREADS) + 1);
+
+   if(remote && target->num_static_nodes() < limit)
+      set_node_owner(tn, target);
+   else if(num_static_nodes() > limit && lightest != this)
+      set_node_owner(tn, lightest);
+}
+
 void
 thread::set_node_cpu(db::node *node, sched::thread *new_owner)
 {
    if(!scheduling_mechanism)
       return;
 
+   node->placed = true;
    set_node_owner(node, new_owner);
 }
 
@@ -499,6 +533,7 @@ thread::set_node_affinity(db::node *node, db::node *affinity)
    if(!scheduling_mechanism)
       return;
    thread *new_owner(affinity->get_owner());
+   node->placed = true;
    set_node_owner(node, new_owner);
 }
 
@@ -19,7 +19,6 @@ ids::commit(void)
 {
    if(total_allocated == 0)
       return;
-   db::database::map_nodes m;
 
    node *p(allocated_nodes);
    while(p) {
@@ -30,11 +29,11 @@ ids::commit(void)
 
          p = next;
       } else {
-         m[p->get_id()] = p;
+         // ids were allocated to this thread, so no lock is needed.
+         All->DATABASE->add_node(p);
          p = p->dyn_next;
       }
    }
-   All->DATABASE->add_node_set(m);
    allocated_nodes = NULL;
    total_allocated = 0;
    deleted_by_others = 0;
@@ -0,0 +1,391 @@
+
+#include <algorithm>
+#include <numeric>
+#include <deque>
+#include <cstdint>
+#include <assert.h>
+
+#include "thread/partition.hpp"
+
+using namespace std;
+
+namespace sched
+{
+
+// coarsening stops once the graph has this many vertices per part
+#define PARTITION_COARSE_VERTICES 20
+// or when a level removes less than 1/PARTITION_MIN_REDUCTION of the vertices.
+#define PARTITION_MIN_REDUCTION 10
+#define PARTITION_REFINE_PASSES 8
+// parts may be this much heavier than the average (percent).
+#define PARTITION_IMBALANCE 3
+
+namespace
+{
+
+struct graph
+{
+   // adjacency lists of all vertices, the neighbors of 'v' are
+   // adj[start[v]] ... adj[start[v + 1] - 1].
+   vector<size_t> start;
+   vector<size_t> adj;
+   vector<size_t> weight;
+   vector<size_t> vweight;
+
+   inline size_t size(void) const { return vweight.size(); }
+};
+
+#define NO_VERTEX SIZE_MAX
+
+// makes the graph undirected and merges repeated edges into their weight.
+graph
+build_graph(const size_t n, const vector<pair<size_t, size_t>>& edges)
+{
+   vector<size_t> start(n + 1, 0);
+   for(const auto& e : edges) {
+      if(e.first == e.second || e.first >= n || e.second >= n)
+         continue;
+      start[e.first + 1]++;
+      start[e.second + 1]++;
+   }
+   for(size_t v(0); v < n; ++v)
+      start[v + 1] += start[v];
+   vector<size_t> adj(start[n]);
+   vector<size_t> pos(start.begin(), start.end() - 1);
+   for(const auto& e : edges) {
+      if(e.first == e.second || e.first >= n || e.second >= n)
+         continue;
+      adj[pos[e.first]++] = e.second;
+      adj[pos[e.second]++] = e.first;
+   }
+
+   graph g;
+   g.vweight.assign(n, 1);
+   g.start.reserve(n + 1);
+   g.start.push_back(0);
+   for(size_t v(0); v < n; ++v) {
+      auto b(adj.begin() + start[v]), e(adj.begin() + start[v + 1]);
+      sort(b, e);
+      for(auto it(b); it != e; ) {
+         auto next(it);
+         while(next != e && *next == *it)
+            ++next;
+         g.adj.push_back(*it);
+         g.weight.push_back(next - it);
+         it = next;
+      }
+      g.start.push_back(g.adj.size());
+   }
+   return g;
+}
+
+// collapses a heavy edge matching. cmap maps the vertices to the new graph.
+graph
+coarsen(const graph& g, vector<size_t>& cmap, const size_t max_vweight)
+{
+   const size_t n(g.size());
+   vector<size_t> order(n);
+   iota(order.begin(), order.end(), 0);
+   // visit the vertices in a fixed pseudo random order.
+   uint64_t seed(n * 2654435761ULL + 1);
+   for(size_t i(n); i > 1; --i) {
+      seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+      swap(order[i - 1], order[(seed >> 33) % i]);
+   }
+
+   vector<size_t> match(n, NO_VERTEX);
+   for(const size_t v : order) {
+      if(match[v] != NO_VERTEX)
+         continue;
+      size_t best(v), best_weight(0);
+      for(size_t k(g.start[v]); k < g.start[v + 1]; ++k) {
+         const size_t u(g.adj[k]);
+         if(match[u] == NO_VERTEX && g.weight[k] > best_weight &&
+               g.vweight[v] + g.vweight[u] <= max_vweight) {
+            best = u;
+            best_weight = g.weight[k];
+         }
+      }
+      match[v] = best;
+      match[best] = v;
+   }
+
+   // coarse vertices are numbered by their smallest vertex.
+   cmap.assign(n, NO_VERTEX);
+   size_t c(0);
+   for(size_t v(0); v < n; ++v) {
+      if(cmap[v] == NO_VERTEX) {
+         cmap[v] = cmap[match[v]] = c;
+         c++;
+      }
+   }
+
+   graph cg;
+   cg.vweight.assign(c, 0);
+   cg.start.reserve(c + 1);
+   cg.start.push_back(0);
+   // position of each coarse neighbor in the list being built.
+   vector<size_t> where(c, NO_VERTEX);
+   for(size_t v(0); v < n; ++v) {
+      if(match[v] < v)
+         continue;
+      const size_t cv(cmap[v]);
+      const size_t begin(cg.adj.size());
+      const size_t members[2] = {v, match[v]};
+      for(size_t i(0); i < (match[v] == v ? 1 : 2); ++i) {
+         const size_t m(members[i]);
+         cg.vweight[cv] += g.vweight[m];
+         for(size_t k(g.start[m]); k < g.start[m + 1]; ++k) {
+            const size_t cu(cmap[g.adj[k]]);
+            if(cu == cv)
+               continue;
+            if(where[cu] != NO_VERTEX && where[cu] >= begin)
+               cg.weight[where[cu]] += g.weight[k];
+            else {
+               where[cu] = cg.adj.size();
+               cg.adj.push_back(cu);
+               cg.weight.push_back(g.weight[k]);
+            }
+         }
+      }
+      cg.start.push_back(cg.adj.size());
+   }
+   return cg;
+}
+
+// grows each part from a seed vertex in breadth first order.
+void
+initial_partition(const graph& g, const size_t parts, vector<size_t>& part)
+{
+   const size_t n(g.size());
+   size_t remaining(accumulate(g.vweight.begin(), g.vweight.end(), (size_t)0));
+   part.assign(n, parts);
+   size_t next_seed(0);
+
+   for(size_t p(0); p < parts - 1; ++p) {
+      const size_t target(remaining / (parts - p));
+      size_t w(0);
+      deque<size_t> q;
+      while(w < target) {
+         size_t v;
+         if(q.empty()) {
+            while(next_seed < n && part[next_seed] != parts)
+               ++next_seed;
+            if(next_seed == n)
+               break;
+            v = next_seed;
+         } else {
+            v = q.front();
+            q.pop_front();
+            if(part[v] != parts)
+               continue;
+         }
+         part[v] = p;
+         w += g.vweight[v];
+         for(size_t k(g.start[v]); k < g.start[v + 1]; ++k) {
+            if(part[g.adj[k]] == parts)
+               q.push_back(g.adj[k]);
+         }
+      }
+      remaining -= w;
+   }
+   for(size_t v(0); v < n; ++v) {
+      if(part[v] == parts)
+         part[v] = parts - 1;
+   }
+}
+
+// moves vertices to the part they are most connected to as long as the
+// edge cut decreases (or stays the same and the parts get more balanced)
+// and the destination does not get heavier than max_part.
+void
+refine(const graph& g, const size_t parts, vector<size_t>& part, const size_t max_part)
+{
+   const size_t n(g.size());
+   vector<size_t> pw(parts, 0);
+   for(size_t v(0); v < n; ++v)
+      pw[part[v]] += g.vweight[v];
+   vector<size_t> conn(parts, 0);
+   vector<size_t> touched;
+
+   auto connect = [&](const size_t v) {
+      for(size_t k(g.start[v]); k < g.start[v + 1]; ++k) {
+         const size_t q(part[g.adj[k]]);
+         if(conn[q] == 0)
+            touched.push_back(q);
+         conn[q] += g.weight[k];
+      }
+   };
+   auto reset = [&]() {
+      for(const size_t q : touched)
+         conn[q] = 0;
+      touched.clear();
+   };
+   auto move_to = [&](const size_t v, const size_t to) {
+      pw[part[v]] -= g.vweight[v];
+      pw[to] += g.vweight[v];
+      part[v] = to;
+   };
+
+   // first empty the parts that are too heavy, losing as few edges as possible.
+   for(size_t v(0); v < n; ++v) {
+      const size_t from(part[v]);
+      if(pw[from] <= max_part)
+         continue;
+      connect(v);
+      size_t best(from);
+      for(const size_t q : touched) {
+         if(q != from && pw[q] + g.vweight[v] <= max_part &&
+               (best == from || conn[q] > conn[best]))
+            best = q;
+      }
+      reset();
+      if(best == from) {
+         best = min_element(pw.begin(), pw.end()) - pw.begin();
+         if(pw[best] + g.vweight[v] > max_part)
+            continue;
+      }
+      move_to(v, best);
+   }
+
+   for(size_t pass(0); pass < PARTITION_REFINE_PASSES; ++pass) {
+      size_t moves(0);
+      for(size_t v(0); v < n; ++v) {
+         const size_t from(part[v]);
+         connect(v);
+         const size_t own(conn[from]);
+         size_t best(from);
+         size_t best_conn(own);
+         for(const size_t q : touched) {
+            if(q == from || pw[q] + g.vweight[v] > max_part)
+               continue;
+            if(conn[q] > best_conn ||
+                  (conn[q] == best_conn && pw[q] + g.vweight[v] < pw[best == from ? from : best])) {
+               best = q;
+               best_conn = conn[q];
+            }
+         }
+         reset();
+         if(best != from && (best_conn > own || pw[best] + g.vweight[v] < pw[from])) {
+            move_to(v, best);
+            moves++;
+         }
+      }
+      if(moves == 0)
+         break;
+   }
+}
+
+}
+
+graph_partition
+partition_graph(const size_t num_vertices,
+      const vector<pair<size_t, size_t>>& edges, const size_t num_parts)
+{
+   graph_partition ret;
+   vector<graph> levels;
+   vector<vector<size_t>> maps;
+
+   levels.push_back(build_graph(num_vertices, edges));
+   ret.part.assign(num_vertices, 0);
+
+   if(num_parts > 1 && num_vertices > 0) {
+      const size_t coarse_target(num_parts * PARTITION_COARSE_VERTICES);
+      const size_t max_vweight(num_vertices / coarse_target * 3 / 2 + 1);
+      while(levels.back().size() > coarse_target) {
+         vector<size_t> cmap;
+         graph cg(coarsen(levels.back(), cmap, max_vweight));
+         if(cg.size() * PARTITION_MIN_REDUCTION >
+               levels.back().size() * (PARTITION_MIN_REDUCTION - 1))
+            break;
+         levels.push_back(std::move(cg));
+         maps.push_back(std::move(cmap));
+      }
+
+      const size_t max_part(max((num_vertices + num_parts - 1) / num_parts,
+               num_vertices * (100 + PARTITION_IMBALANCE) / (100 * num_parts)));
+      vector<size_t> part;
+      initial_partition(levels.back(), num_parts, part);
+      refine(levels.back(), num_parts, part, max_part);
+      for(size_t l(levels.size() - 1); l > 0; --l) {
+         vector<size_t> fine(levels[l - 1].size());
+         for(size_t v(0); v < fine.size(); ++v)
+            fine[v] = part[maps[l - 1][v]];
+         part.swap(fine);
+         refine(levels[l - 1], num_parts, part, max_part);
+      }
+      ret.part.swap(part);
+   }
+
+   const graph& g(levels[0]);
+   vector<size_t> pw(max(num_parts, (size_t)1), 0);
+   for(size_t v(0); v < num_vertices; ++v) {
+      pw[ret.part[v]]++;
+      for(size_t k(g.start[v]); k < g.start[v + 1]; ++k) {
+         ret.total_edges += g.weight[k];
+         if(ret.part[g.adj[k]] != ret.part[v])
+            ret.edge_cut += g.weight[k];
+      }
+   }
+   // every edge was seen from both ends.
+   ret.total_edges /= 2;
+   ret.edge_cut /= 2;
+   if(num_vertices > 0)
+      ret.balance = (double)*max_element(pw.begin(), pw.end()) * pw.size() / num_vertices;
+   return ret;
+}
+
+vector<size_t>
+order_graph(const size_t num_vertices,
+      const vector<pair<size_t, size_t>>& edges, const vertex_order order)
+{
+   vector<size_t> ret(num_vertices);
+   iota(ret.begin(), ret.end(), 0);
+   if(order == ORDER_ID)
+      return ret;
+
+   const graph g(build_graph(num_vertices, edges));
+   auto by_degree = [&g](const size_t a, const size_t b) {
+      return g.start[a + 1] - g.start[a] < g.start[b + 1] - g.start[b];
+   };
+
+   if(order == ORDER_DEGREE) {
+      stable_sort(ret.rbegin(), ret.rend(), by_degree);
+      return ret;
+   }
+
+   // each component is visited from the first root it contains.
+   vector<size_t> roots(ret);
+   if(order == ORDER_RCM)
+      stable_sort(roots.begin(), roots.end(), by_degree);
+
+   vector<bool> visited(num_vertices, false);
+   vector<size_t> neighbors;
+   size_t head(0), tail(0);
+   for(const size_t root : roots) {
+      if(visited[root])
+         continue;
+      visited[root] = true;
+      ret[tail++] = root;
+      while(head < tail) {
+         const size_t v(ret[head++]);
+         neighbors.clear();
+         for(size_t k(g.start[v]); k < g.start[v + 1]; ++k) {
+            const size_t u(g.adj[k]);
+            if(!visited[u]) {
+               visited[u] = true;
+               neighbors.push_back(u);
+            }
+         }
+         if(order == ORDER_RCM)
+            stable_sort(neighbors.begin(), neighbors.end(), by_degree);
+         for(const size_t u : neighbors)
+            ret[tail++] = u;
+      }
+   }
+   if(order == ORDER_RCM)
+      reverse(ret.begin(), ret.end());
+   return ret;
+}
+
+}
@@ -0,0 +1,47 @@
+
+#ifndef THREAD_PARTITION_HPP
+#define THREAD_PARTITION_HPP
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+namespace sched
+{
+
+// Multilevel graph partitioning (Karypis and Kumar, 1998).
+// The graph is coarsened by collapsing heavy edges, the coarsest graph is
+// split by growing regions and the partition is refined while it is
+// projected back to the original graph.
+struct graph_partition
+{
+   // part of each vertex.
+   std::vector<size_t> part;
+   // number of edges between different parts.
+   size_t edge_cut{0};
+   size_t total_edges{0};
+   // weight of the heaviest part divided by the average weight.
+   double balance{1.0};
+};
+
+// vertices go from 0 to num_vertices - 1. edges may be repeated and
+// appear in both directions, self loops are ignored.
+graph_partition partition_graph(const size_t num_vertices,
+      const std::vector<std::pair<size_t, size_t>>& edges, const size_t num_parts);
+
+enum vertex_order {
+   ORDER_ID,
+   // Reverse Cuthill-McKee: breadth first from a low degree vertex,
+   // neighbors by increasing degree, then reversed.
+   ORDER_RCM,
+   ORDER_DEGREE,
+   ORDER_BFS
+};
+
+// returns the vertices sorted so that neighbors end up close together.
+std::vector<size_t> order_graph(const size_t num_vertices,
+      const std::vector<std::pair<size_t, size_t>>& edges, const vertex_order order);
+
+}
+
+#endif
@@ -0,0 +1,146 @@
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+#include "thread/partition.hpp"
+
+class ThreadPartitionTests : public TestFixture {
+   public:
+
+#define PARTITION_TEST_SIDE 100
+#define PARTITION_TEST_PARTS 4
+
+      // grid where the vertex ids are shuffled, so that contiguous id
+      // ranges cut most of the edges.
+      std::vector<std::pair<size_t, size_t>> shuffled_grid(void)
+      {
+         const size_t n(PARTITION_TEST_SIDE * PARTITION_TEST_SIDE);
+         std::vector<size_t> id(n);
+         for(size_t i(0); i < n; ++i)
+            id[i] = i;
+         size_t seed(7);
+         for(size_t i(n); i > 1; --i) {
+            seed = seed * 1103515245 + 12345;
+            std::swap(id[i - 1], id[(seed >> 8) % i]);
+         }
+         std::vector<std::pair<size_t, size_t>> edges;
+         for(size_t r(0); r < PARTITION_TEST_SIDE; ++r) {
+            for(size_t c(0); c < PARTITION_TEST_SIDE; ++c) {
+               const size_t v(r * PARTITION_TEST_SIDE + c);
+               if(c + 1 < PARTITION_TEST_SIDE)
+                  edges.push_back(std::make_pair(id[v], id[v + 1]));
+               if(r + 1 < PARTITION_TEST_SIDE)
+                  edges.push_back(std::make_pair(id[v], id[v + PARTITION_TEST_SIDE]));
+            }
+         }
+         return edges;
+      }
+
+      void testSinglePart(void)
+      {
+         std::vector<std::pair<size_t, size_t>> edges;
+         edges.push_back(std::make_pair(0, 1));
+         edges.push_back(std::make_pair(1, 2));
+         edges.push_back(std::make_pair(2, 2));
+         sched::graph_partition p(sched::partition_graph(3, edges, 1));
+         CPPUNIT_ASSERT(p.part.size() == 3);
+         CPPUNIT_ASSERT(p.edge_cut == 0);
+         // self loops do not count.
+         CPPUNIT_ASSERT(p.total_edges == 2);
+         CPPUNIT_ASSERT(p.balance == 1.0);
+      }
+
+      void testNoEdges(void)
+      {
+         std::vector<std::pair<size_t, size_t>> edges;
+         sched::graph_partition p(sched::partition_graph(1000, edges, PARTITION_TEST_PARTS));
+         std::vector<size_t> count(PARTITION_TEST_PARTS, 0);
+         for(const size_t q : p.part) {
+            CPPUNIT_ASSERT(q < PARTITION_TEST_PARTS);
+            count[q]++;
+         }
+         for(const size_t c : count)
+            CPPUNIT_ASSERT(c == 1000 / PARTITION_TEST_PARTS);
+         CPPUNIT_ASSERT(p.edge_cut == 0);
+      }
+
+      void testGrid(void)
+      {
+         const size_t n(PARTITION_TEST_SIDE * PARTITION_TEST_SIDE);
+         const std::vector<std::pair<size_t, size_t>> edges(shuffled_grid());
+         sched::graph_partition p(sched::partition_graph(n, edges, PARTITION_TEST_PARTS));
+
+         size_t range_cut(0), cut(0);
+         for(const auto& e : edges) {
+            if(e.first * PARTITION_TEST_PARTS / n != e.second * PARTITION_TEST_PARTS / n)
+               range_cut++;
+            if(p.part[e.first] != p.part[e.second])
+               cut++;
+         }
+         CPPUNIT_ASSERT(p.total_edges == edges.size());
+         CPPUNIT_ASSERT(p.edge_cut == cut);
+         CPPUNIT_ASSERT(p.balance <= 1.03);
+         // the best cut splits the grid in quadrants (2 * side edges).
+         CPPUNIT_ASSERT(cut < 2 * 2 * PARTITION_TEST_SIDE);
+         std::cout << std::endl << "partition: " << n << " vertices, " << edges.size()
+            << " edges, cut " << cut << " (id ranges " << range_cut
+            << "), balance " << p.balance << std::endl;
+      }
+
+      // largest distance in the order between the ends of an edge.
+      size_t bandwidth(const std::vector<size_t>& order,
+            const std::vector<std::pair<size_t, size_t>>& edges)
+      {
+         std::vector<size_t> pos(order.size());
+         for(size_t i(0); i < order.size(); ++i)
+            pos[order[i]] = i;
+         size_t ret(0);
+         for(const auto& e : edges)
+            ret = std::max(ret, pos[e.first] > pos[e.second] ?
+                  pos[e.first] - pos[e.second] : pos[e.second] - pos[e.first]);
+         return ret;
+      }
+
+      void testOrder(void)
+      {
+         const size_t n(PARTITION_TEST_SIDE * PARTITION_TEST_SIDE);
+         const std::vector<std::pair<size_t, size_t>> edges(shuffled_grid());
+         const sched::vertex_order orders[] = {sched::ORDER_ID, sched::ORDER_RCM,
+            sched::ORDER_DEGREE, sched::ORDER_BFS};
+
+         for(const sched::vertex_order o : orders) {
+            std::vector<size_t> order(sched::order_graph(n, edges, o));
+            CPPUNIT_ASSERT(order.size() == n);
+            std::vector<size_t> sorted(order);
+            std::sort(sorted.begin(), sorted.end());
+            for(size_t i(0); i < n; ++i)
+               CPPUNIT_ASSERT(sorted[i] == i);
+         }
+
+         const size_t by_id(bandwidth(sched::order_graph(n, edges, sched::ORDER_ID), edges));
+         const size_t rcm(bandwidth(sched::order_graph(n, edges, sched::ORDER_RCM), edges));
+         // breadth first from a corner keeps neighbors within two diagonals.
+         CPPUNIT_ASSERT(rcm <= 2 * PARTITION_TEST_SIDE);
+         CPPUNIT_ASSERT(rcm * 10 < by_id);
+
+         // the degree order starts with the inner vertices.
+         std::vector<size_t> degree(n, 0);
+         for(const auto& e : edges) {
+            degree[e.first]++;
+            degree[e.second]++;
+         }
+         const std::vector<size_t> by_degree(sched::order_graph(n, edges, sched::ORDER_DEGREE));
+         for(size_t i(1); i < n; ++i)
+            CPPUNIT_ASSERT(degree[by_degree[i - 1]] >= degree[by_degree[i]]);
+      }
+
+      CPPUNIT_TEST_SUITE(ThreadPartitionTests);
+
+      CPPUNIT_TEST(testSinglePart);
+      CPPUNIT_TEST(testNoEdges);
+      CPPUNIT_TEST(testGrid);
+      CPPUNIT_TEST(testOrder);
+      CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ThreadPartitionTests);
@@ -0,0 +1,383 @@
+
+#ifndef THREAD_RELAXED_PRIORITY_QUEUE_HPP
+#define THREAD_RELAXED_PRIORITY_QUEUE_HPP
+
+#include <atomic>
+#include <vector>
+
+#include "utils/mutex.hpp"
+#include "utils/utils.hpp"
+#include "queue/safe_complex_pqueue.hpp"
+#include "queue/bucket_pqueue.hpp"
+#include "db/node.hpp"
+#include "vm/all.hpp"
+
+namespace sched {
+
+// relaxed priority queue (MultiQueue) made of several heaps with their own lock.
+// nodes go to a random heap and pops take the best top of two random heaps,
+// therefore threads updating priorities of nodes rarely wait on the same lock.
+// the heap of each node is kept in the intrusive extra id.
+// with a single heap the queue behaves like intrusive_safe_complex_pqueue.
+// each heap may be replaced by a delta-stepping bucket queue.
+struct relaxed_priority_queue {
+   using queue_t = queue::intrusive_safe_complex_pqueue<db::node>;
+   using bucket_t = queue::intrusive_bucket_pqueue<db::node>;
+#define MAX_RELAXED_HEAPS 64
+#define RELAXED_HEAPS_PER_THREAD 4
+
+   private:
+
+   // the lock of 'heap' also protects 'buckets'.
+   struct sub_heap {
+      queue_t heap;
+      // used instead of 'heap' if not null.
+      bucket_t *buckets{nullptr};
+      // top of the heap, read without the lock to choose where to pop from.
+      std::atomic<bool> has_nodes{false};
+      std::atomic<vm::priority_t> top{0};
+
+      inline bool empty(void) const { return buckets ? buckets->empty() : heap.empty(); }
+
+      inline bool contains(db::node *node) const
+      {
+         return __INTRUSIVE_QUEUE(node) == heap.queue_number;
+      }
+
+      inline vm::priority_t top_priority(void)
+      {
+         return __INTRUSIVE_PRIORITY(buckets ? buckets->front() : heap.heap.front());
+      }
+
+      inline void do_insert(db::node *node, const vm::priority_t prio)
+      {
+         if(buckets)
+            buckets->do_insert(node, prio);
+         else
+            heap.do_insert(node, prio);
+      }
+
+      inline db::node* do_pop(const queue_id_t new_state)
+      {
+         return buckets ? buckets->do_pop(new_state) : heap.do_pop(new_state);
+      }
+
+      inline void do_remove(db::node *node, const queue_id_t new_state)
+      {
+         if(buckets)
+            buckets->do_remove(node, new_state);
+         else
+            heap.do_remove(node, new_state);
+      }
+
+      inline size_t do_pop_half(db::node **buffer, const size_t max, const queue_id_t new_state)
+      {
+         if(buckets)
+            return buckets->do_pop_half(buffer, max, new_state);
+         return heap.do_pop_half(buffer, max, new_state);
+      }
+
+      inline void do_move_node(db::node *node, const vm::priority_t new_prio)
+      {
+         if(buckets)
+            buckets->do_move_node(node, new_prio);
+         else
+            heap.do_move_node(node, new_prio);
+      }
+
+      // must hold the heap lock.
+      inline void refresh(void)
+      {
+         if(empty())
+            has_nodes.store(false, std::memory_order_relaxed);
+         else {
+            top.store(top_priority(), std::memory_order_relaxed);
+            has_nodes.store(true, std::memory_order_relaxed);
+         }
+      }
+
+      explicit sub_heap(const queue_id_t id, const bool use_buckets, const double delta):
+         heap(id)
+      {
+         if(use_buckets)
+            buckets = new bucket_t(id, delta);
+      }
+
+      ~sub_heap(void) { delete buckets; }
+   };
+
+   std::vector<sub_heap*> heaps;
+   std::atomic<size_t> total{0};
+
+   inline size_t random_heap(void) const
+   {
+      if(heaps.size() == 1)
+         return 0;
+      return utils::random_unsigned(heaps.size());
+   }
+
+   inline bool better(const sub_heap& a, const sub_heap& b) const
+   {
+      if(!a.has_nodes.load(std::memory_order_relaxed))
+         return false;
+      if(!b.has_nodes.load(std::memory_order_relaxed))
+         return true;
+      return heaps[0]->heap.compare(a.top.load(std::memory_order_relaxed),
+            b.top.load(std::memory_order_relaxed));
+   }
+
+   // picks the best of two random heaps.
+   inline sub_heap* sample(void)
+   {
+      sub_heap *a(heaps[random_heap()]);
+      if(heaps.size() == 1)
+         return a;
+      sub_heap *b(heaps[random_heap()]);
+      return better(*b, *a) ? b : a;
+   }
+
+   // returns 'h' or, if it looks empty, some other heap that has nodes.
+   inline sub_heap* with_nodes(sub_heap *h)
+   {
+      if(heaps.size() == 1 || h->has_nodes.load(std::memory_order_relaxed))
+         return h;
+      const size_t start(random_heap());
+      for(size_t i(0); i < heaps.size(); ++i) {
+         sub_heap *o(heaps[(start + i) % heaps.size()]);
+         if(o->has_nodes.load(std::memory_order_relaxed))
+            return o;
+      }
+      return h;
+   }
+
+   // must hold the lock of 'h'.
+   inline db::node* do_pop(sub_heap& h, const queue_id_t new_state)
+   {
+      db::node *ret(h.do_pop(new_state));
+      if(ret) {
+         total--;
+         h.refresh();
+      }
+      return ret;
+   }
+
+#ifdef INSTRUMENTATION
+   // counts a pop and checks if some heap of both queues had a better top.
+   inline void check_inversion(const vm::priority_t prio, const relaxed_priority_queue& other)
+   {
+      pops++;
+      const relaxed_priority_queue *queues[2] = {this, &other};
+      for(const relaxed_priority_queue *q : queues) {
+         for(const sub_heap *h : q->heaps) {
+            if(h->has_nodes.load(std::memory_order_relaxed) &&
+                  !heaps[0]->heap.compare(prio, h->top.load(std::memory_order_relaxed))) {
+               inversions++;
+               return;
+            }
+         }
+      }
+   }
+#endif
+
+   public:
+
+#ifdef INSTRUMENTATION
+   std::atomic<size_t> pops{0};
+   std::atomic<size_t> inversions{0};
+   // pops where the chosen heap no longer had the top that was used to choose it.
+   std::atomic<size_t> stale{0};
+#endif
+
+   inline bool empty() const { return total.load(std::memory_order_relaxed) == 0; }
+   inline size_t size() const { return total.load(std::memory_order_relaxed); }
+   inline size_t num_heaps() const { return heaps.size(); }
+
+   inline vm::priority_t min_value(void)
+   {
+      sub_heap *best(heaps[0]);
+      for(sub_heap *h : heaps) {
+         if(better(*h, *best))
+            best = h;
+      }
+      if(!best->has_nodes.load(std::memory_order_relaxed))
+         return 0.0;
+      return best->top.load(std::memory_order_relaxed);
+   }
+
+   inline void start_initial_insert(const size_t many) {
+      const size_t n(heaps.size());
+      for(size_t i(0); i < n; ++i) {
+         const size_t part((many + n - 1 - i) / n);
+         if(heaps[i]->buckets)
+            heaps[i]->buckets->start_initial_insert(part);
+         else
+            heaps[i]->heap.start_initial_insert(part);
+      }
+      total = many;
+   }
+
+   inline void initial_fast_insert(db::node* node, const vm::priority_t prio,
+                                   const size_t i) {
+      sub_heap& h(*heaps[i % heaps.size()]);
+
+      __INTRUSIVE_EXTRA_ID(node) = i % heaps.size();
+      if(h.buckets)
+         h.buckets->initial_fast_insert(node, prio, i / heaps.size());
+      else
+         h.heap.initial_fast_insert(node, prio, i / heaps.size());
+      // all initial nodes have the same priority.
+      h.top.store(prio, std::memory_order_relaxed);
+      h.has_nodes.store(true, std::memory_order_relaxed);
+   }
+
+   inline void insert(db::node* node,
+                      const vm::priority_t prio LOCKING_STAT_FLAG) {
+      const size_t idx(random_heap());
+      sub_heap& h(*heaps[idx]);
+
+      MUTEX_LOCK_GUARD_FLAG(h.heap.mtx, priority_lock, coord_priority_lock);
+      __INTRUSIVE_EXTRA_ID(node) = idx;
+      h.do_insert(node, prio);
+      total++;
+      h.refresh();
+   }
+
+   inline db::node* pop(const queue_id_t new_state) {
+      // the chosen heap may be emptied before we get its lock.
+      while(!empty()) {
+         sub_heap& h(*with_nodes(sample()));
+         MUTEX_LOCK_GUARD(h.heap.mtx, priority_lock);
+         db::node *ret(do_pop(h, new_state));
+         if(ret)
+            return ret;
+      }
+      return nullptr;
+   }
+
+   inline bool remove(db::node* node,
+                      const queue_id_t new_state LOCKING_STAT_FLAG) {
+      while(true) {
+         // the node may be inserted into another heap while we wait for the lock.
+         const size_t idx(__INTRUSIVE_EXTRA_ID(node));
+         sub_heap& h(*heaps[idx]);
+
+         MUTEX_LOCK_GUARD_FLAG(h.heap.mtx, priority_lock, coord_priority_lock);
+         if((size_t)__INTRUSIVE_EXTRA_ID(node) != idx)
+            continue;
+         if(h.empty())
+            return false;
+         if(!h.contains(node))
+            return false;
+         h.do_remove(node, new_state);
+         total--;
+         h.refresh();
+         return true;
+      }
+   }
+
+   inline size_t pop_half(db::node** buffer, const size_t max,
+                          const queue_id_t new_state) {
+      while(!empty()) {
+         sub_heap& h(*with_nodes(heaps[random_heap()]));
+
+         MUTEX_LOCK_GUARD(h.heap.mtx, priority_lock);
+         if(h.empty())
+            continue;
+         const size_t ret(h.do_pop_half(buffer, max, new_state));
+         total -= ret;
+         h.refresh();
+         return ret;
+      }
+      return 0;
+   }
+
+   inline db::node* pop_best(relaxed_priority_queue& other,
+                             const queue_id_t new_state) {
+      if(heaps.size() == 1 && other.heaps.size() == 1) {
+         // exact queue.
+         sub_heap& h1(*heaps[0]);
+         sub_heap& h2(*other.heaps[0]);
+         MUTEX_LOCK_GUARD_NAME(l1, h1.heap.mtx, priority_lock);
+         MUTEX_LOCK_GUARD_NAME(l2, h2.heap.mtx, priority_lock);
+
+         if(h1.empty()) {
+            if(h2.empty())
+               return nullptr;
+            return other.do_pop(h2, new_state);
+         }
+         if(h2.empty() || h1.heap.compare(h1.top_priority(), h2.top_priority()))
+            return do_pop(h1, new_state);
+         return other.do_pop(h2, new_state);
+      }
+
+      while(!empty() || !other.empty()) {
+         sub_heap *mine(empty() ? nullptr : sample());
+         sub_heap *theirs(other.empty() ? nullptr : other.sample());
+         relaxed_priority_queue *q(this);
+         sub_heap *h(mine);
+
+         if(mine == nullptr || (theirs && better(*theirs, *mine))) {
+            q = &other;
+            h = theirs;
+         }
+
+         const vm::priority_t seen(h->top.load(std::memory_order_relaxed));
+         MUTEX_LOCK_GUARD(h->heap.mtx, priority_lock);
+         if(h->empty())
+            continue;
+#ifdef INSTRUMENTATION
+         if(h->top_priority() != seen)
+            stale++;
+         check_inversion(h->top_priority(), other);
+#else
+         (void)seen;
+#endif
+         return q->do_pop(*h, new_state);
+      }
+      return nullptr;
+   }
+
+   inline void move_node(db::node* node,
+                         const vm::priority_t new_prio LOCKING_STAT_FLAG) {
+      while(true) {
+         const size_t idx(__INTRUSIVE_EXTRA_ID(node));
+         sub_heap& h(*heaps[idx]);
+
+         MUTEX_LOCK_GUARD_FLAG(h.heap.mtx, priority_lock, coord_priority_lock);
+         if((size_t)__INTRUSIVE_EXTRA_ID(node) != idx)
+            continue;
+         if(!h.contains(node))
+            return;  // not in the queue
+         h.do_move_node(node, new_prio);
+         h.refresh();
+         return;
+      }
+   }
+
+   void set_type(const heap_type _typ) {
+      for(sub_heap *h : heaps) {
+         h->heap.set_type(_typ);
+         if(h->buckets)
+            h->buckets->set_type(_typ);
+      }
+   }
+
+   // with 'use_buckets' a 'delta' of 0 tunes the bucket width automatically.
+   explicit relaxed_priority_queue(const queue_id_t id, const size_t n = 1,
+         const bool use_buckets = false, const double delta = 0.0) {
+      assert(n > 0 && n <= MAX_RELAXED_HEAPS);
+      for(size_t i(0); i < n; ++i)
+         heaps.push_back(new sub_heap(id, use_buckets, delta));
+   }
+
+   relaxed_priority_queue(const relaxed_priority_queue&) = delete;
+   relaxed_priority_queue& operator=(const relaxed_priority_queue&) = delete;
+
+   ~relaxed_priority_queue(void) {
+      for(sub_heap *h : heaps)
+         delete h;
+   }
+};
+}
+
+#endif
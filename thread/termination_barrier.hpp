@@ -3,52 +3,167 @@
 #define THREAD_TERMINATION_BARRIER_HPP
 
 #include <atomic>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <assert.h>
 
-#include "vm/state.hpp"
 #include "utils/macros.hpp"
 
 namespace sched
 {
-   
+
+// Counts active threads with a tree of counters instead of a single
+// counter so that threads only write to the counter of their group.
+// Each counter is a scalable non-zero indicator (Ellen et al., 2007):
+// a counter only tells its parent when it becomes zero or non-zero, and
+// the root becomes zero only when no thread is active.
 class termination_barrier
 {
 private:
-   
-   std::atomic<size_t> active_threads;
-   
+
+// threads (or counters) that share a counter.
+#define TERMINATION_RADIX 4
+
+   // the state of a counter is twice the count plus a version in the
+   // high bits. a count of 1/2 means that the counter is arriving at
+   // its parent.
+   struct counter
+   {
+      std::atomic<uint64_t> state;
+      counter *parent;
+      char __pad[64 - sizeof(std::atomic<uint64_t>) - sizeof(counter*)];
+
+#define COUNTER_HALF ((uint64_t)1)
+#define COUNTER_ONE ((uint64_t)2)
+#define COUNTER_MASK (((uint64_t)1 << 32) - 1)
+#define COUNTER_VERSION ((uint64_t)1 << 32)
+
+      static inline uint64_t count(const uint64_t x) { return x & COUNTER_MASK; }
+   };
+
+   std::vector<counter*> counters;
+   std::vector<counter*> leaves;
+   counter *root;
+
    std::atomic<bool> done;
-   
+
+   void arrive(counter *c)
+   {
+      if(c == nullptr)
+         return;
+      bool success(false);
+      size_t undo(0);
+      while(!success) {
+         uint64_t x(c->state.load());
+         uint64_t expected(x);
+         if(counter::count(x) >= COUNTER_ONE) {
+            if(c->state.compare_exchange_strong(expected, x + COUNTER_ONE))
+               success = true;
+         } else if(counter::count(x) == 0) {
+            const uint64_t half((x & ~COUNTER_MASK) + COUNTER_VERSION + COUNTER_HALF);
+            if(c->state.compare_exchange_strong(expected, half)) {
+               success = true;
+               x = half;
+            }
+         }
+         if(counter::count(x) == COUNTER_HALF) {
+            // help the arrival at the parent.
+            arrive(c->parent);
+            expected = x;
+            if(!c->state.compare_exchange_strong(expected, x - COUNTER_HALF + COUNTER_ONE))
+               undo++;
+         }
+      }
+      // other threads finished the arrival at the parent.
+      for(; undo > 0; --undo)
+         depart(c->parent);
+   }
+
+   void depart(counter *c)
+   {
+      if(c == nullptr) {
+         done = true;
+         return;
+      }
+      while(true) {
+         uint64_t x(c->state.load());
+         assert(counter::count(x) >= COUNTER_ONE);
+         if(c->state.compare_exchange_strong(x, x - COUNTER_ONE)) {
+            if(counter::count(x) == COUNTER_ONE)
+               depart(c->parent);
+            return;
+         }
+      }
+   }
+
 public:
-   
+
    inline void reset(void) { done = false; }
    inline void set_done(void) { done = true; }
-   
-   inline void is_active(void)
+
+   inline void is_active(const size_t id)
    {
-      active_threads++;
+      arrive(leaves[id / TERMINATION_RADIX]);
    }
-   
-   inline void is_inactive(void)
+
+   inline void is_inactive(const size_t id)
    {
-      assert(active_threads > 0);
-      if(--active_threads == 0)
-         done = true;
+      depart(leaves[id / TERMINATION_RADIX]);
+   }
+
+   // approximate, only the leaves are read.
+   inline size_t num_active(void) const
+   {
+      size_t total(0);
+      for(counter *c : leaves)
+         total += counter::count(c->state.load()) / COUNTER_ONE;
+      return total;
    }
-   
-   inline size_t num_active(void) const { return active_threads; }
-   
+
    inline bool all_finished(void) const { return done; }
-   
-   // we use this for MPI, because in MPI the counter can reach zero and 
+
+   // we use this for MPI, because in MPI the counter can reach zero and
    // and become positive since we can get new work from remote threads
-   inline bool zero_active_threads(void) const { return active_threads == 0; }
-   
-   explicit termination_barrier(const size_t _num_threads):
-      active_threads(_num_threads), done(false)
+   inline bool zero_active_threads(void) const { return counter::count(root->state.load()) == 0; }
+
+   explicit termination_barrier(const size_t num_threads):
+      done(false)
+   {
+      assert(num_threads > 0);
+      // all threads start active, so each counter starts with
+      // the number of its children.
+      std::vector<counter*> level;
+      for(size_t i(0); i < num_threads; i += TERMINATION_RADIX) {
+         counter *c(new counter());
+         c->state = std::min((size_t)TERMINATION_RADIX, num_threads - i) * COUNTER_ONE;
+         c->parent = nullptr;
+         counters.push_back(c);
+         level.push_back(c);
+      }
+      leaves = level;
+      while(level.size() > 1) {
+         std::vector<counter*> up;
+         for(size_t i(0); i < level.size(); i += TERMINATION_RADIX) {
+            counter *c(new counter());
+            const size_t children(std::min((size_t)TERMINATION_RADIX, level.size() - i));
+            c->state = children * COUNTER_ONE;
+            c->parent = nullptr;
+            for(size_t j(i); j < i + children; ++j)
+               level[j]->parent = c;
+            counters.push_back(c);
+            up.push_back(c);
+         }
+         level = up;
+      }
+      root = level[0];
+   }
+
+   ~termination_barrier(void)
    {
+      for(counter *c : counters)
+         delete c;
    }
-   
-   ~termination_barrier(void) {}
 };
 
 }
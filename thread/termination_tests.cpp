@@ -0,0 +1,150 @@
+
+#include <thread>
+#include <vector>
+#include <atomic>
+
+#include "thread/termination_barrier.hpp"
+
+class ThreadTerminationTests : public TestFixture {
+   public:
+
+#define TERMINATION_TEST_THREADS 19
+#define TERMINATION_TEST_ROUNDS 10
+#define TERMINATION_TEST_ITEMS 1000
+
+      enum { INACTIVE, ACTIVATING, ACTIVE, ACTIVE_NEW_WORK };
+
+      struct worker {
+         std::atomic<int> state;
+         std::atomic<size_t> work;
+      };
+
+      void testSingleThread(void)
+      {
+         sched::termination_barrier b(1);
+         CPPUNIT_ASSERT(b.num_active() == 1);
+         CPPUNIT_ASSERT(!b.all_finished());
+         b.is_inactive(0);
+         CPPUNIT_ASSERT(b.all_finished());
+         CPPUNIT_ASSERT(b.zero_active_threads());
+      }
+
+      void testTree(void)
+      {
+         sched::termination_barrier b(TERMINATION_TEST_THREADS);
+         CPPUNIT_ASSERT(b.num_active() == TERMINATION_TEST_THREADS);
+         for(size_t i(0); i < TERMINATION_TEST_THREADS - 1; ++i) {
+            b.is_inactive(i);
+            CPPUNIT_ASSERT(!b.all_finished());
+         }
+         // becomes active again and then everyone leaves.
+         b.is_active(0);
+         b.is_inactive(TERMINATION_TEST_THREADS - 1);
+         CPPUNIT_ASSERT(!b.all_finished());
+         CPPUNIT_ASSERT(!b.zero_active_threads());
+         CPPUNIT_ASSERT(b.num_active() == 1);
+         b.is_inactive(0);
+         CPPUNIT_ASSERT(b.all_finished());
+         CPPUNIT_ASSERT(b.num_active() == 0);
+      }
+
+      void activate(sched::termination_barrier& b, worker& w, const size_t id)
+      {
+         while(true) {
+            int old(w.state.load());
+            if(old == INACTIVE) {
+               if(w.state.compare_exchange_strong(old, ACTIVATING)) {
+                  b.is_active(id);
+                  w.state = ACTIVE_NEW_WORK;
+                  return;
+               }
+            } else if(old == ACTIVE) {
+               if(w.state.compare_exchange_strong(old, ACTIVE_NEW_WORK))
+                  return;
+            } else
+               return;
+         }
+      }
+
+      // threads send work to each other and wake up the inactive ones like
+      // the schedulers do. the barrier must not finish while work remains.
+      void run_round(const size_t seed)
+      {
+         const size_t n(TERMINATION_TEST_THREADS);
+         sched::termination_barrier b(n);
+         std::vector<worker> workers(n);
+         std::atomic<size_t> pending(0);
+         std::atomic<bool> premature(false);
+
+         for(size_t i(0); i < n; ++i) {
+            workers[i].state = ACTIVE_NEW_WORK;
+            workers[i].work = i == 0 ? TERMINATION_TEST_ITEMS : 0;
+         }
+         pending = TERMINATION_TEST_ITEMS;
+
+         auto run = [&](const size_t id) {
+            size_t rnd(seed * 7919 + id * 104729 + 1);
+            worker& me(workers[id]);
+            while(true) {
+               size_t w(me.work.load());
+               if(w > 0) {
+                  if(!me.work.compare_exchange_strong(w, w - 1))
+                     continue;
+                  rnd = rnd * 6364136223846793005ULL + 1442695040888963407ULL;
+                  // send at most two items while the amount of work is bounded.
+                  const size_t sends((rnd >> 33) % 3);
+                  for(size_t s(0); s < sends && pending.load() < 4 * TERMINATION_TEST_ITEMS; ++s) {
+                     const size_t target((rnd >> (40 + s * 8)) % n);
+                     pending++;
+                     workers[target].work++;
+                     activate(b, workers[target], target);
+                  }
+                  pending--;
+                  continue;
+               }
+               // new work may have been sent after we looked at the queue.
+               int old(ACTIVE_NEW_WORK);
+               if(me.state.compare_exchange_strong(old, ACTIVE))
+                  continue;
+               old = ACTIVE;
+               if(!me.state.compare_exchange_strong(old, INACTIVE))
+                  continue;
+               b.is_inactive(id);
+               while(me.state.load() != ACTIVE_NEW_WORK) {
+                  if(b.all_finished()) {
+                     if(pending.load() != 0)
+                        premature = true;
+                     return;
+                  }
+                  std::this_thread::yield();
+               }
+            }
+         };
+
+         std::vector<std::thread> threads;
+         for(size_t i(0); i < n; ++i)
+            threads.push_back(std::thread(run, i));
+         for(std::thread& t : threads)
+            t.join();
+
+         CPPUNIT_ASSERT(!premature);
+         CPPUNIT_ASSERT(pending == 0);
+         CPPUNIT_ASSERT(b.all_finished());
+         CPPUNIT_ASSERT(b.zero_active_threads());
+      }
+
+      void testPrematureTermination(void)
+      {
+         for(size_t i(0); i < TERMINATION_TEST_ROUNDS; ++i)
+            run_round(i);
+      }
+
+      CPPUNIT_TEST_SUITE(ThreadTerminationTests);
+
+      CPPUNIT_TEST(testSingleThread);
+      CPPUNIT_TEST(testTree);
+      CPPUNIT_TEST(testPrematureTermination);
+      CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ThreadTerminationTests);
@@ -38,6 +38,7 @@ tree_barrier *thread::thread_barrier(nullptr);
 termination_barrier *thread::term_barrier(nullptr);
 
 std::atomic<bool> thread::stop_flag(false);
+std::atomic<size_t> thread::bsp_active[3];
 
 static std::mutex m;
 
@@ -84,7 +85,10 @@ void thread::do_loop(void) {
 void thread::loop(void) {
    init(All->NUM_THREADS);
 
-   do_loop();
+   if (bsp_mode)
+      bsp_loop();
+   else
+      do_loop();
 
    assert_end();
    end();
@@ -166,6 +170,78 @@ void thread::new_work(node *from, node *to, vm::tuple *tpl, vm::predicate *pred,
    NODE_UNLOCK(to, nodelock);
 }
 
+void thread::new_work_delay(node *from, node *to, vm::tuple *tpl,
+                            vm::predicate *pred, const derivation_direction dir,
+                            const depth_t depth, const vm::uint_val delay) {
+   if (delay == 0) {
+      new_work(from, to, tpl, pred, dir, depth);
+      return;
+   }
+#ifdef GC_NODES
+   // the tuple lives in the target's arena, keep the node alive.
+   if (!All->DATABASE->is_initial_node(to)) to->refs++;
+#endif
+   delayed_fact *f(mem::allocator<delayed_fact>().allocate(1));
+   f->target = to;
+   f->tpl = tpl;
+   f->pred = pred;
+   f->dir = dir;
+   f->depth = depth;
+   timers.add(f, delay);
+}
+
+void thread::fire_timers(void) {
+   timers.expire(timers.now(), [this](delayed_fact *f) {
+      db::node *to(f->target);
+      new_work(to, to, f->tpl, f->pred, f->dir, f->depth);
+#ifdef GC_NODES
+      // the node has new facts, it will be collected when it runs out of them.
+      if (!All->DATABASE->is_initial_node(to)) to->refs--;
+#endif
+      mem::allocator<delayed_fact>().deallocate(f, 1);
+   });
+}
+
+void thread::wait_for_timers(void) {
+// longest sleep, so that work sent by other threads is not left waiting.
+#define TIMER_MAX_SLEEP std::chrono::milliseconds(1)
+   const timer_wheel::clock::time_point next(timers.time_of(timers.next_tick()));
+   const timer_wheel::clock::time_point limit(timer_wheel::clock::now() +
+                                              TIMER_MAX_SLEEP);
+   std::this_thread::sleep_until(min(next, limit));
+   fire_timers();
+}
+
+#ifdef IDLE_PARKING
+bool thread::park(void) {
+   // returns true if the thread was woken up by another thread.
+#ifdef INSTRUMENTATION
+   parks++;
+#endif
+   const int64_t latency(parking.park(park_timeout, [this]() {
+      return is_inactive() && !has_work() && !all_threads_finished() &&
+             !stop_flag;
+   }));
+   if (latency < 0) {
+      park_timeout = min(park_timeout * 2, THREAD_PARK_MAX);
+      return false;
+   }
+#ifdef INSTRUMENTATION
+   wakeups++;
+   wakeup_latency += latency / 1000;
+#endif
+   return true;
+}
+
+void thread::wake_all_threads(void) {
+   for (size_t i(0); i < All->NUM_THREADS; ++i) {
+      thread *t(static_cast<thread *>(All->SCHEDS[i]));
+      if (t) t->parking.unpark();
+   }
+}
+
+#endif
+
 #ifdef TASK_STEALING
 bool thread::go_steal_nodes(void) {
    // Function returns 'true' if there are new nodes in the thread.
@@ -178,19 +254,28 @@ bool thread::go_steal_nodes(void) {
 #ifdef STEAL_ONE
 #define NODE_BUFFER_SIZE 1
 #elif defined(STEAL_HALF)
+#ifdef STEALING_DEQUE
+// thieves take half of the victim's nodes up to this limit,
+// so batches grow with the amount of work left.
+#define NODE_BUFFER_SIZE 64
+#else
 #define NODE_BUFFER_SIZE 16
+#endif
 #endif
    db::node *node_buffer[NODE_BUFFER_SIZE];
    bool activated{false};
    bool has_work{false};
 
-   for (size_t i(0); i < All->NUM_THREADS; ++i) {
-      const size_t tid((next_thread + i) % All->NUM_THREADS);
+   // first try to steal from threads on the same socket.
+   for (size_t k(0); k < 2 * All->NUM_THREADS; ++k) {
+      const bool same_socket(k < All->NUM_THREADS);
+      const size_t tid((next_thread + k) % All->NUM_THREADS);
       if (this == All->SCHEDS[tid]) continue;
 
       assert(tid < All->NUM_THREADS);
       thread *target((thread *)All->SCHEDS[tid]);
 
+      if ((target->get_socket() == get_socket()) != same_socket) continue;
       if (!target->is_active() || !target->has_work()) continue;
 
       if(!activated) {
@@ -295,7 +380,12 @@ size_t thread::steal_nodes(db::node **buffer, const size_t max) {
 }
 #endif
 
-void thread::killed_while_active(void) { set_force_inactive(); }
+void thread::killed_while_active(void) {
+   set_force_inactive();
+#ifdef IDLE_PARKING
+   wake_all_threads();
+#endif
+}
 
 bool thread::busy_wait(void) {
 #ifdef TASK_STEALING
@@ -329,6 +419,12 @@ bool thread::busy_wait(void) {
          }
       }
 #endif
+      if (!timers.empty()) {
+         // the thread stays active until its delayed facts are delivered.
+         if (stop_flag) return false;
+         wait_for_timers();
+         continue;
+      }
       const bool has_new_work(set_inactive_if_no_work());
       if (has_new_work) {
          ins_active;
@@ -338,12 +434,31 @@ bool thread::busy_wait(void) {
       }
       if (all_threads_finished() || stop_flag) {
          assert(is_inactive());
+#ifdef IDLE_PARKING
+         wake_all_threads();
+#endif
          return false;
       }
+#ifdef IDLE_PARKING
+      if (idle_rounds++ >= THREAD_SPIN_ROUNDS) {
+         if (!park()) {
+#ifdef TASK_STEALING
+            // the timeout expired, try to steal before parking again.
+            count = backoff - 1;
+#endif
+         }
+         continue;
+      }
+#endif
       cpu_relax();
       std::this_thread::yield();
    }
 
+#ifdef IDLE_PARKING
+   idle_rounds = 0;
+   park_timeout = THREAD_PARK_MIN;
+#endif
+
    // since queue pushing and state setting are done in
    // different exclusive regions, this may be needed
    set_active_if_inactive();
@@ -401,7 +516,11 @@ inline bool thread::set_next_node(void) {
 
    if (current_node != nullptr) check_if_current_useless();
 
+   if (!timers.empty()) fire_timers();
+
    while (current_node == nullptr) {
+      if (!inbox.empty()) process_inbox();
+
       current_node = prios.moving.pop_best(prios.stati, STATE_WORKING);
       if (current_node) {
 #ifdef DEBUG_QUEUE
@@ -445,6 +564,76 @@ inline bool thread::set_next_node(void) {
    return true;
 }
 
+void thread::process_inbox(void) { process_batches(inbox.pop_all()); }
+
+void thread::process_batches(vm::thread_batch *batch) {
+   while (batch) {
+      vm::thread_batch *next(batch->next);
+      // nodes stolen in the meantime are forwarded to their new owner.
+      for (vm::buffer_pair &p : batch->nodes)
+         new_work_list(nullptr, p.node, p.b);
+      vm::thread_batch::destroy(batch);
+      batch = next;
+   }
+}
+
+bool thread::bsp_next_node(void) {
+#ifndef DIRECT_PRIORITIES
+   check_priority_buffer();
+#endif
+
+   if (current_node != nullptr) check_if_current_useless();
+   // the node got new facts while running.
+   if (current_node != nullptr) return true;
+
+   current_node = prios.moving.pop_best(prios.stati, STATE_WORKING);
+   if (current_node) return true;
+   if (pop_node_from_queues()) return true;
+   if (thread_node && thread_node->unprocessed_facts) {
+      current_node = thread_node;
+      return true;
+   }
+   return false;
+}
+
+void thread::bsp_loop(void) {
+   // nodes are never stolen, each superstep runs the nodes of this
+   // thread with new facts and then all threads wait for each other.
+   while (true) {
+      const size_t step(superstep);
+      process_batches(bsp_inbox[step & 1].pop_all());
+      if (!timers.empty()) fire_timers();
+
+      bool ran(false);
+      while (!stop_flag && bsp_next_node()) {
+         state.run_node(current_node);
+         ran = true;
+      }
+      if (!ran && !timers.empty() && !stop_flag) wait_for_timers();
+
+      threads_synchronize();
+      // nodes only run before the first barrier, so every thread reads
+      // the same stop flag here and all of them leave together.
+      const bool stop(stop_flag);
+      if (has_work() || !bsp_inbox[(step + 1) & 1].empty() || !timers.empty() ||
+          (thread_node && thread_node->unprocessed_facts))
+         bsp_active[step % 3]++;
+      if (leader_thread()) bsp_active[(step + 1) % 3] = 0;
+      threads_synchronize();
+
+      if (stop) {
+         killed_while_active();
+         return;
+      }
+      if (bsp_active[step % 3] == 0) break;
+      superstep++;
+   }
+
+   if (leader_thread() && time_execution)
+      cout << "Supersteps: " << superstep + 1 << endl;
+   set_force_inactive();
+}
+
 node *thread::get_work(void) {
    if (!set_next_node()) return nullptr;
 
@@ -470,13 +659,10 @@ void thread::end(void) {
    size_t total_prioritized(0);
    size_t total_nonprioritized(0);
 
-   database::map_nodes::iterator it(
-       state::DATABASE->get_node_iterator(All->MACHINE->find_first_node(id)));
-   database::map_nodes::iterator end(
-       state::DATABASE->get_node_iterator(All->MACHINE->find_last_node(id)));
+   const db::node::node_id *end(All->MACHINE->owned_nodes_end(id));
 
-   for (; it != end; ++it) {
-      db::node *cur_node(it->second);
+   for (const db::node::node_id *i(All->MACHINE->owned_nodes_begin(id)); i != end; ++i) {
+      db::node *cur_node(All->DATABASE->find_node(*i));
 
       if (cur_node->has_been_prioritized)
          ++total_prioritized;
@@ -501,6 +687,9 @@ void thread::run_const_code(void) {
 #endif
 
 void thread::init(const size_t) {
+#ifdef INSTRUMENTATION
+   has_cpu_clock = pthread_getcpuclockid(pthread_self(), &cpu_clock) == 0;
+#endif
    // normal priorities
    if (theProgram->is_priority_desc()) {
       prios.moving.set_type(HEAP_DESC);
@@ -510,23 +699,25 @@ void thread::init(const size_t) {
       prios.stati.set_type(HEAP_ASC);
    }
 
-   auto it(All->DATABASE->get_node_iterator(All->MACHINE->find_first_node(id)));
-   auto end(All->DATABASE->get_node_iterator(All->MACHINE->find_last_node(id)));
+   const db::node::node_id *first(All->MACHINE->owned_nodes_begin(id));
+   const db::node::node_id *end(All->MACHINE->owned_nodes_end(id));
    priority_t initial(theProgram->get_initial_priority());
 
    if (initial == vm::no_priority_value()) {
-      for (; it != end; ++it) {
-         db::node *cur_node(init_node(it));
-         queues.moving.push_tail(cur_node);
+      for (const db::node::node_id *nid(first); nid != end; ++nid) {
+         db::node *cur_node(init_node(*nid));
+         if (cur_node) queues.moving.push_tail(cur_node);
       }
    } else {
       prios.moving.start_initial_insert(All->MACHINE->find_owned_nodes(id));
       size_t total{0};
 
-      for (size_t i(0); it != end; ++it, ++i) {
-         db::node *cur_node(init_node(it));
+      size_t i(0);
+      for (const db::node::node_id *nid(first); nid != end; ++nid) {
+         db::node *cur_node(init_node(*nid));
+         if (!cur_node) continue;
 
-         prios.moving.initial_fast_insert(cur_node, initial, i);
+         prios.moving.initial_fast_insert(cur_node, initial, i++);
          total++;
       }
       //cout << total << endl;
@@ -630,6 +821,20 @@ void thread::write_slice(statistics::slice &sl) {
    sl.thread_transactions = thread_transactions.exchange(0);
    sl.all_transactions = all_transactions.exchange(0);
    sl.node_difference = node_difference;
+   sl.priority_pops = prios.moving.pops.exchange(0) + prios.stati.pops.exchange(0);
+   sl.priority_inversions = prios.moving.inversions.exchange(0) + prios.stati.inversions.exchange(0);
+   sl.priority_stale = prios.moving.stale.exchange(0) + prios.stati.stale.exchange(0);
+#ifdef IDLE_PARKING
+   sl.parks = parks.exchange(0);
+   sl.wakeups = wakeups.exchange(0);
+   sl.wakeup_latency = wakeup_latency.exchange(0);
+#endif
+   struct timespec ts;
+   if (has_cpu_clock && clock_gettime(cpu_clock, &ts) == 0) {
+      const int64_t now(ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+      sl.cpu_time = now - last_cpu_time;
+      last_cpu_time = now;
+   }
 
 #ifdef TASK_STEALING
    sl.stolen_nodes = stolen_total.exchange(0);
@@ -639,7 +844,9 @@ void thread::write_slice(statistics::slice &sl) {
 
 thread::thread(const vm::process_id _id)
     : id(_id),
-    state(this)
+    socket(All->MACHINE->find_thread_socket(_id)),
+    state(this),
+    prios(relaxed_priorities ? RELAXED_HEAPS_PER_THREAD : 1, bucket_priorities, bucket_width)
 #ifdef TASK_STEALING
       ,
       rand(_id * 1000),
@@ -662,6 +869,17 @@ thread::thread(const vm::process_id _id)
 
 thread::~thread(void) {
    bitmap::destroy(comm_threads, All->NUM_THREADS_NEXT_UINT);
+   // facts not delivered when the program was stopped.
+   vm::candidate_gc_nodes gc_nodes;
+   timers.destroy([&gc_nodes](delayed_fact *f) {
+      db::node *to(f->target);
+      vm::tuple::destroy(f->tpl, f->pred, &(to->alloc), gc_nodes);
+#ifdef GC_NODES
+      // the database frees the node when it is wiped out.
+      if (!All->DATABASE->is_initial_node(to)) to->refs--;
+#endif
+      mem::allocator<delayed_fact>().deallocate(f, 1);
+   });
    assert(tstate == THREAD_INACTIVE);
    if (theProgram->has_thread_predicates()) delete_node(thread_node);
 }
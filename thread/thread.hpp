@@ -5,16 +5,24 @@
 #include <vector>
 
 #include "db/database.hpp"
+#include "vm/state.hpp"
 #include "thread/ids.hpp"
 #include "queue/safe_linear_queue.hpp"
 #include "thread/termination_barrier.hpp"
 #include "queue/safe_complex_pqueue.hpp"
 #include "queue/safe_double_queue.hpp"
+#include "queue/stealing_deque.hpp"
+#include "queue/push_safe_stack.hpp"
 #include "utils/random.hpp"
 #include "utils/circular_buffer.hpp"
 #include "utils/tree_barrier.hpp"
 #include "vm/bitmap.hpp"
 //#include "thread/priority_queue.hpp"
+#include "thread/relaxed_priority_queue.hpp"
+#include "thread/timer_wheel.hpp"
+#ifdef IDLE_PARKING
+#include "utils/parker.hpp"
+#endif
 #ifdef INSTRUMENTATION
 #include "stat/stat.hpp"
 #include "stat/slice.hpp"
@@ -77,6 +85,8 @@ class thread: public mem::base
 private:
    
    const vm::process_id id;
+   // socket where the thread runs (0 if threads are not pinned).
+   const size_t socket;
    char __pad[1024];
 
    vm::state state;
@@ -118,18 +128,23 @@ public:
       while(true) {
          utils::byte old_val(tstate);
          if(old_val == THREAD_INACTIVE) {
-            if(cmpxchg(&tstate, old_val, active_work) == old_val) {
-               term_barrier->is_active();
-               return;
-            }
+            // count the thread as active before it can run and become
+            // inactive again. the caller is active so undoing it is safe.
+            term_barrier->is_active(get_id());
+            if(cmpxchg(&tstate, old_val, active_work) == old_val)
+               break;
+            term_barrier->is_inactive(get_id());
          } else if(old_val == THREAD_ACTIVE) {
             if(cmpxchg(&tstate, old_val, active_work) == old_val)
                return;
          } else if(old_val == (THREAD_ACTIVE | THREAD_NEW_WORK)) {
-            return;
+            break;
          }
          cpu_relax();
       }
+#ifdef IDLE_PARKING
+      parking.unpark();
+#endif
    }
    
    inline bool set_active_if_inactive(void)
@@ -139,7 +154,7 @@ public:
          utils::byte old_val(tstate);
          if(old_val == THREAD_INACTIVE) {
             if(cmpxchg(&tstate, old_val, active) == old_val) {
-               term_barrier->is_active();
+               term_barrier->is_active(get_id());
                return false;
             }
          } else if(old_val == THREAD_ACTIVE) {
@@ -163,7 +178,7 @@ public:
             return false;
          else if(old_val == THREAD_ACTIVE) {
             if(cmpxchg(&tstate, old_val, inactive) == old_val) {
-               term_barrier->is_inactive();
+               term_barrier->is_inactive(get_id());
                return false;
             }
          } else if(old_val == (THREAD_ACTIVE | THREAD_NEW_WORK)) {
@@ -184,7 +199,7 @@ public:
             return;
          else if(old_val == active) {
             if(cmpxchg(&tstate, old_val, inactive) == old_val) {
-               term_barrier->is_inactive();
+               term_barrier->is_inactive(get_id());
                return;
             }
          } else if(old_val == (active | THREAD_NEW_WORK)) {
@@ -210,8 +225,14 @@ public:
    void do_loop(void);
    
    using node_queue = queue::intrusive_safe_double_queue<db::node>;
+#ifdef STEALING_DEQUE
+   // moving nodes can be stolen, static nodes cannot.
+   using moving_node_queue = queue::intrusive_stealing_deque<db::node>;
+#else
+   using moving_node_queue = node_queue;
+#endif
    struct Queues {
-      node_queue moving;
+      moving_node_queue moving;
       node_queue stati;
 
       inline bool has_work(void) const
@@ -226,7 +247,7 @@ public:
       }
    } queues;
 
-	using priority_queue = queue::intrusive_safe_complex_pqueue<db::node>;
+	using priority_queue = sched::relaxed_priority_queue;
   // using priority_queue = sched::priority_queue;
 
    struct Priorities {
@@ -237,9 +258,9 @@ public:
          return !moving.empty() || !stati.empty();
       }
 
-      explicit Priorities(void):
-         moving(PRIORITY_MOVING),
-         stati(PRIORITY_STATIC)
+      explicit Priorities(const size_t heaps, const bool buckets, const double delta):
+         moving(PRIORITY_MOVING, heaps, buckets, delta),
+         stati(PRIORITY_STATIC, heaps, buckets, delta)
       {
       }
    } prios;
@@ -255,6 +276,41 @@ public:
    db::node *current_node{nullptr};
    vm::bitmap comm_threads; // threads we may need to communicate with
 
+   // facts that other threads sent to the nodes of this thread.
+   queue::push_safe_intrusive_stack<vm::thread_batch> inbox;
+   void process_inbox(void);
+   void process_batches(vm::thread_batch *);
+
+   // bulk synchronous mode: facts sent during a superstep are delivered
+   // at the start of the next one, so the inboxes alternate.
+   queue::push_safe_intrusive_stack<vm::thread_batch> bsp_inbox[2];
+   size_t superstep{0};
+   // threads with work left at the end of a superstep. the counters are
+   // reused every 3 supersteps, so the next one can be cleared while
+   // the current one is being read.
+   static std::atomic<size_t> bsp_active[3];
+   bool bsp_next_node(void);
+   void bsp_loop(void);
+
+   // facts sent with a delay by the nodes run by this thread.
+   timer_wheel timers;
+   void fire_timers(void);
+   void wait_for_timers(void);
+
+#ifdef IDLE_PARKING
+   // idle threads spin for a while and then sleep until they are woken
+   // up or the timeout expires. the timeout doubles while the thread
+   // remains idle so that it can still steal nodes from time to time.
+#define THREAD_SPIN_ROUNDS 128
+#define THREAD_PARK_MIN std::chrono::microseconds(50)
+#define THREAD_PARK_MAX std::chrono::microseconds(4000)
+   utils::parker parking;
+   std::chrono::microseconds park_timeout{THREAD_PARK_MIN};
+   size_t idle_rounds{0};
+   bool park(void);
+   static void wake_all_threads(void);
+#endif
+
    inline bool pop_node_from_queues(void)
    {
       if(queues.stati.pop_head(current_node, STATE_WORKING))
@@ -291,6 +347,16 @@ public:
    std::atomic<size_t> all_transactions{0};
    db::node::node_id last_node{0};
    std::atomic<int32_t> node_difference{0};
+#ifdef IDLE_PARKING
+   std::atomic<size_t> parks{0};
+   std::atomic<size_t> wakeups{0};
+   // microseconds between unpark and the thread running again.
+   std::atomic<size_t> wakeup_latency{0};
+#endif
+   // cpu time of the thread, in microseconds.
+   clockid_t cpu_clock;
+   bool has_cpu_clock{false};
+   int64_t last_cpu_time{0};
 #endif
 
 #ifndef DIRECT_PRIORITIES
@@ -330,6 +396,7 @@ public:
       if(old != nullptr)
          old->static_nodes--;
 
+      tn->placed = false;
       tn->set_moving();
    }
 
@@ -351,14 +418,35 @@ public:
          else
             queues.moving.push_tail(node);
       }
+#ifdef IDLE_PARKING
+      // a wakeup missed here is only delayed until the park timeout.
+      parking.unpark();
+#endif
    }
    
    bool has_work(void) const
    {
-      return queues.has_work() || prios.has_work();
+      return queues.has_work() || prios.has_work() || !inbox.empty();
    }
 
    void move_node_to_new_owner(db::node *, thread *);
+
+   // static nodes are moved to the thread that gets most of their facts.
+#define THREAD_PLACEMENT_SAMPLES 64
+// threads may have this many more static nodes than the average (percent).
+#define THREAD_STATIC_IMBALANCE 25
+   inline void sample_send(db::node *from, thread *to)
+   {
+      if(from->comm_votes == 0) {
+         from->comm_candidate = to;
+         from->comm_votes = 1;
+      } else if(from->comm_candidate == to)
+         from->comm_votes++;
+      else
+         from->comm_votes--;
+      from->comm_samples++;
+   }
+   void check_node_placement(db::node *);
    void do_set_node_priority_other(db::node *, const vm::priority_t);
    void do_remove_node_priority_other(db::node *);
 
@@ -388,6 +476,7 @@ public:
    static std::atomic<bool> stop_flag;
 
    inline vm::process_id get_id(void) const { return id; }
+   inline size_t get_socket(void) const { return socket; }
    inline utils::randgen *get_random() { return &rand; }
    inline utils::randgen *get_random() const { return &rand; }
    
@@ -397,9 +486,11 @@ public:
       return queues.stati.size() + queues.moving.size() + prios.stati.size() + prios.moving.size();
    }
 
-   db::node* init_node(db::database::map_nodes::iterator it)
+   db::node* init_node(const db::node::node_id id)
    {
-      db::node *node(vm::All->DATABASE->create_node_iterator(it));
+      db::node *node(vm::All->DATABASE->create_initial_node(id));
+      if(node == nullptr)
+         return nullptr;
       vm::theProgram->fix_node_address(node);
 #ifdef GC_NODES
       // initial nodes never get deleted.
@@ -438,6 +529,20 @@ public:
       assert(is_active());
       (void)from;
 
+      if (to->get_owner() != this) {
+         // the batch goes into the node's inbox without locking.
+         // only the sender that finds the inbox empty needs to lock
+         // the node in order to make sure that it gets scheduled.
+#ifdef INSTRUMENTATION
+         sent_facts_other_thread += b.size();
+         all_transactions++;
+         thread_transactions++;
+#endif
+         if (to->store.inbox.push(vm::buffer_batch::create(b)))
+            schedule_inbox_node(to);
+         return;
+      }
+
       LOCK_STACK(nodelock);
 
       NODE_LOCK(to, nodelock, node_lock);
@@ -455,25 +560,14 @@ public:
 #endif
          if (!to->active_node()) add_to_queue(to);
       } else {
-         LOCK_STACK(databaselock);
-         if (to->database_lock.try_lock1(LOCK_STACK_USE(databaselock))) {
-            LOCKING_STAT(database_lock_ok);
-            to->add_work_myself(b);
-#ifdef INSTRUMENTATION
-            sent_facts_other_thread_now += b.size();
-            all_transactions++;
-            thread_transactions++;
-#endif
-            MUTEX_UNLOCK(to->database_lock, databaselock);
-         } else {
-            LOCKING_STAT(database_lock_fail);
+         // node was stolen in the meantime.
 #ifdef INSTRUMENTATION
-            sent_facts_other_thread += b.size();
-            all_transactions++;
-            thread_transactions++;
+         sent_facts_other_thread += b.size();
+         all_transactions++;
+         thread_transactions++;
 #endif
-            to->add_work_others(b);
-         }
+         to->store.inbox.push(vm::buffer_batch::create(b));
+         to->unprocessed_facts = true;
          if (!to->active_node()) {
             owner->add_to_queue(to);
             comm_threads.set_bit(owner->get_id());
@@ -481,13 +575,53 @@ public:
       }
 
       NODE_UNLOCK(to, nodelock);
-}
+   }
 
-   void new_work_delay(db::node *, db::node *, vm::tuple*, vm::predicate *,
-         const vm::derivation_direction, const vm::depth_t, const vm::uint_val)
+   // queues facts for the next superstep of 'owner', which may be this thread.
+   inline void bsp_send(thread *owner, vm::thread_batch *batch)
+   {
+      owner->bsp_inbox[(superstep + 1) & 1].push(batch);
+   }
+
+   // hands over the facts for several nodes of 'owner' at once.
+   inline void new_work_batch(thread *owner, vm::thread_batch *batch)
+   {
+      assert(is_active());
+      assert(owner != this);
+#ifdef INSTRUMENTATION
+      all_transactions++;
+      thread_transactions++;
+#endif
+      if (owner->inbox.push(batch)) {
+#ifdef IDLE_PARKING
+         owner->parking.unpark();
+#endif
+      }
+      comm_threads.set_bit(owner->get_id());
+   }
+
+   inline void schedule_inbox_node(db::node *to)
    {
-      assert(false);
+      LOCK_STACK(nodelock);
+
+      NODE_LOCK(to, nodelock, node_lock);
+
+      to->unprocessed_facts = true;
+      if (!to->active_node()) {
+         thread *owner(to->get_owner());
+         if (owner == this)
+            add_to_queue(to);
+         else {
+            owner->add_to_queue(to);
+            comm_threads.set_bit(owner->get_id());
+         }
+      }
+
+      NODE_UNLOCK(to, nodelock);
    }
+
+   void new_work_delay(db::node *, db::node *, vm::tuple*, vm::predicate *,
+         const vm::derivation_direction, const vm::depth_t, const vm::uint_val);
    
    db::node* get_work(void);
    void end(void);
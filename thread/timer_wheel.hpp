@@ -0,0 +1,203 @@
+
+#ifndef THREAD_TIMER_WHEEL_HPP
+#define THREAD_TIMER_WHEEL_HPP
+
+#include <cstdint>
+#include <chrono>
+#include <algorithm>
+#include <assert.h>
+
+#include "mem/allocator.hpp"
+#include "vm/defs.hpp"
+#include "vm/tuple.hpp"
+#include "vm/predicate.hpp"
+
+namespace db { struct node; }
+
+namespace sched
+{
+
+// a fact sent with a delay that has not been delivered yet.
+struct delayed_fact {
+   db::node *target;
+   vm::tuple *tpl;
+   vm::predicate *pred;
+   vm::derivation_direction dir;
+   vm::depth_t depth;
+   uint64_t deadline;
+   delayed_fact *next;
+};
+
+// Hierarchical timer wheel used by each thread to keep the facts sent with a delay.
+// Ticks are milliseconds since the wheel was created. Level 0 has one slot
+// per tick for the next TIMER_WHEEL_SLOTS ticks and each of the next levels
+// has slots that are TIMER_WHEEL_SLOTS times larger than the previous level.
+// Facts in higher levels are moved to lower levels when the wheel reaches
+// their slot, therefore insertion and expiration are O(1).
+// Only the owner thread uses the wheel.
+class timer_wheel
+{
+public:
+
+   using clock = std::chrono::steady_clock;
+
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_LEVELS 4
+
+private:
+
+   delayed_fact *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+   // last tick that was processed.
+   uint64_t current{0};
+   size_t total{0};
+   const clock::time_point start;
+
+   inline void place(delayed_fact *f)
+   {
+      // facts placed while cascading may expire in the current tick
+      // since its slot is processed after the cascade.
+      uint64_t deadline(f->deadline);
+      if(deadline < current)
+         deadline = current;
+      const uint64_t delta(deadline - current);
+      size_t level(0);
+      while(level < TIMER_WHEEL_LEVELS - 1 &&
+            delta >= ((uint64_t)1 << (TIMER_WHEEL_BITS * (level + 1))))
+         level++;
+      if(level == TIMER_WHEEL_LEVELS - 1) {
+         // facts beyond the range of the wheel wait in the last slot
+         // before the current one and are placed again later.
+         const uint64_t range((uint64_t)1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS));
+         if(delta >= range)
+            deadline = current + range - 1;
+      }
+      const size_t idx((deadline >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK);
+      f->next = slots[level][idx];
+      slots[level][idx] = f;
+   }
+
+   // moves the facts of the current slot of 'level' to lower levels.
+   inline void cascade(const size_t level)
+   {
+      const size_t idx((current >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK);
+      delayed_fact *f(slots[level][idx]);
+      slots[level][idx] = nullptr;
+      while(f) {
+         delayed_fact *next(f->next);
+         place(f);
+         f = next;
+      }
+   }
+
+public:
+
+   inline bool empty() const { return total == 0; }
+   inline size_t size() const { return total; }
+
+   inline uint64_t now() const
+   {
+      return std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+   }
+
+   inline clock::time_point time_of(const uint64_t tick) const
+   {
+      return start + std::chrono::milliseconds(tick);
+   }
+
+   inline void add(delayed_fact *f, const uint64_t delay_ms)
+   {
+      add(f, delay_ms, now());
+   }
+
+   // 'tick' is the current time.
+   inline void add(delayed_fact *f, const uint64_t delay_ms, const uint64_t tick)
+   {
+      if(total == 0)
+         // nothing to expire, no need to walk the idle ticks.
+         current = tick;
+      // the slot of the current tick may have been processed already.
+      f->deadline = std::max(tick, current) + std::max(delay_ms, (uint64_t)1);
+      place(f);
+      total++;
+   }
+
+   // number of facts kept in 'level'.
+   inline size_t count(const size_t level) const
+   {
+      size_t ret(0);
+      for(size_t i(0); i < TIMER_WHEEL_SLOTS; ++i) {
+         for(const delayed_fact *f(slots[level][i]); f; f = f->next)
+            ret++;
+      }
+      return ret;
+   }
+
+   // earliest tick at which some fact may expire.
+   // facts in higher levels only move down when the wheel reaches their
+   // slot, so the result is never later than the real deadline.
+   inline uint64_t next_tick() const
+   {
+      for(size_t i(1); i < TIMER_WHEEL_SLOTS; ++i) {
+         if(slots[0][(current + i) & TIMER_WHEEL_MASK])
+            return current + i;
+      }
+      return (current | TIMER_WHEEL_MASK) + 1;
+   }
+
+   // calls 'f' for each fact whose deadline has passed.
+   template <typename F>
+   inline void expire(const uint64_t until, F f)
+   {
+      while(total > 0 && current < until) {
+         current++;
+         for(size_t level(1); level < TIMER_WHEEL_LEVELS; ++level) {
+            if((current & (((uint64_t)1 << (TIMER_WHEEL_BITS * level)) - 1)) != 0)
+               break;
+            cascade(level);
+         }
+         const size_t idx(current & TIMER_WHEEL_MASK);
+         delayed_fact *ls(slots[0][idx]);
+         slots[0][idx] = nullptr;
+         while(ls) {
+            delayed_fact *next(ls->next);
+            assert(total > 0);
+            total--;
+            f(ls);
+            ls = next;
+         }
+      }
+   }
+
+   // calls 'f' for each fact that was never delivered.
+   // like in expire(), 'f' owns the fact and must release it.
+   template <typename F>
+   inline void destroy(F f)
+   {
+      for(size_t level(0); level < TIMER_WHEEL_LEVELS; ++level) {
+         for(size_t i(0); i < TIMER_WHEEL_SLOTS; ++i) {
+            delayed_fact *ls(slots[level][i]);
+            slots[level][i] = nullptr;
+            while(ls) {
+               delayed_fact *next(ls->next);
+               f(ls);
+               ls = next;
+            }
+         }
+      }
+      total = 0;
+   }
+
+   explicit timer_wheel(void):
+      start(clock::now())
+   {
+      for(size_t level(0); level < TIMER_WHEEL_LEVELS; ++level)
+         for(size_t i(0); i < TIMER_WHEEL_SLOTS; ++i)
+            slots[level][i] = nullptr;
+   }
+};
+
+}
+
+#endif
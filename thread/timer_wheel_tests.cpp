@@ -0,0 +1,182 @@
+
+#include <vector>
+
+#include "thread/timer_wheel.hpp"
+
+class ThreadTimerWheelTests : public TestFixture {
+   public:
+
+#define TIMER_TEST_FACTS 2000
+#define TIMER_TEST_MAX_DELAY 20000
+
+      struct collect {
+         std::vector<sched::delayed_fact*> *fired;
+         void operator()(sched::delayed_fact *f) const { fired->push_back(f); }
+      };
+
+      void testLevels(void)
+      {
+         sched::timer_wheel w;
+         // the first delay of each level.
+         const uint64_t delays[TIMER_WHEEL_LEVELS] = {10, 100, 5000, 300000};
+         sched::delayed_fact facts[TIMER_WHEEL_LEVELS];
+         for(size_t i(0); i < TIMER_WHEEL_LEVELS; ++i)
+            w.add(&facts[i], delays[i], 0);
+         for(size_t i(0); i < TIMER_WHEEL_LEVELS; ++i)
+            CPPUNIT_ASSERT(w.count(i) == 1);
+         CPPUNIT_ASSERT(w.size() == TIMER_WHEEL_LEVELS);
+
+         std::vector<sched::delayed_fact*> fired;
+         collect c{&fired};
+         for(size_t i(0); i < TIMER_WHEEL_LEVELS; ++i) {
+            w.expire(delays[i] - 1, c);
+            CPPUNIT_ASSERT(fired.size() == i);
+            w.expire(delays[i], c);
+            CPPUNIT_ASSERT(fired.size() == i + 1);
+            CPPUNIT_ASSERT(fired[i] == &facts[i]);
+            CPPUNIT_ASSERT(facts[i].deadline == delays[i]);
+         }
+         CPPUNIT_ASSERT(w.empty());
+      }
+
+      void testCascade(void)
+      {
+         sched::timer_wheel w;
+         std::vector<sched::delayed_fact*> fired;
+         collect c{&fired};
+         sched::delayed_fact f;
+
+         // goes to slot 1 of level 2 and moves down when the wheel reaches it.
+         w.add(&f, 5000, 0);
+         CPPUNIT_ASSERT(w.count(2) == 1);
+         w.expire(4095, c);
+         CPPUNIT_ASSERT(w.count(2) == 1);
+         w.expire(4096, c);
+         CPPUNIT_ASSERT(w.count(2) == 0);
+         CPPUNIT_ASSERT(w.count(1) == 1);
+         // slot 78 of level 1 starts at tick 78 * 64.
+         w.expire(4991, c);
+         CPPUNIT_ASSERT(w.count(1) == 1);
+         w.expire(4992, c);
+         CPPUNIT_ASSERT(w.count(1) == 0);
+         CPPUNIT_ASSERT(w.count(0) == 1);
+         w.expire(4999, c);
+         CPPUNIT_ASSERT(fired.empty());
+         w.expire(5000, c);
+         CPPUNIT_ASSERT(fired.size() == 1);
+
+         // the wheel restarts at the given tick when it is empty.
+         w.add(&f, 200, 4000);
+         CPPUNIT_ASSERT(w.count(1) == 1);
+         w.expire(4159, c);
+         CPPUNIT_ASSERT(w.count(1) == 1);
+         w.expire(4160, c);
+         CPPUNIT_ASSERT(w.count(0) == 1);
+         w.expire(4200, c);
+         CPPUNIT_ASSERT(fired.size() == 2);
+         CPPUNIT_ASSERT(w.empty());
+      }
+
+      void testOrder(void)
+      {
+         sched::timer_wheel w;
+         std::vector<sched::delayed_fact> facts(TIMER_TEST_FACTS);
+         std::vector<sched::delayed_fact*> fired;
+         size_t seed(11);
+         for(size_t i(0); i < TIMER_TEST_FACTS / 2; ++i) {
+            seed = seed * 1103515245 + 12345;
+            w.add(&facts[i], (seed >> 8) % TIMER_TEST_MAX_DELAY, 0);
+         }
+
+         size_t added(TIMER_TEST_FACTS / 2);
+         bool ok(true);
+         for(uint64_t t(1); !w.empty(); ++t) {
+            w.expire(t, [&](sched::delayed_fact *f) {
+               // facts expire exactly at their deadline.
+               if(f->deadline != t)
+                  ok = false;
+               fired.push_back(f);
+            });
+            // facts added while the wheel runs.
+            if(added < TIMER_TEST_FACTS && t % 10 == 0) {
+               seed = seed * 1103515245 + 12345;
+               w.add(&facts[added++], (seed >> 8) % TIMER_TEST_MAX_DELAY, t);
+            }
+         }
+         CPPUNIT_ASSERT(ok);
+         CPPUNIT_ASSERT(added == TIMER_TEST_FACTS);
+         CPPUNIT_ASSERT(fired.size() == TIMER_TEST_FACTS);
+         for(size_t i(1); i < fired.size(); ++i)
+            CPPUNIT_ASSERT(fired[i - 1]->deadline <= fired[i]->deadline);
+      }
+
+      void testShortDelay(void)
+      {
+         sched::timer_wheel w;
+         std::vector<sched::delayed_fact*> fired;
+         collect c{&fired};
+         sched::delayed_fact zero, one;
+
+         w.add(&zero, 0, 50);
+         w.add(&one, 1, 50);
+         // both expire on the next tick.
+         CPPUNIT_ASSERT(zero.deadline == 51);
+         CPPUNIT_ASSERT(one.deadline == 51);
+         CPPUNIT_ASSERT(w.count(0) == 2);
+         w.expire(50, c);
+         CPPUNIT_ASSERT(fired.empty());
+         w.expire(51, c);
+         CPPUNIT_ASSERT(fired.size() == 2);
+         CPPUNIT_ASSERT(w.empty());
+      }
+
+      void testDestroyPending(void)
+      {
+         std::vector<vm::type*> types;
+         types.push_back(vm::TYPE_INT);
+         vm::predicate *pred(vm::predicate::make_predicate_simple(0, "f", true, types));
+         mem::node_allocator alloc;
+         sched::timer_wheel w;
+         const uint64_t delays[2] = {10, 5000};
+         vm::tuple *tpls[2];
+         for(size_t i(0); i < 2; ++i) {
+            sched::delayed_fact *f(mem::allocator<sched::delayed_fact>().allocate(1));
+            f->target = nullptr;
+            f->tpl = tpls[i] = vm::tuple::create(pred, &alloc);
+            f->pred = pred;
+            w.add(f, delays[i], 0);
+         }
+
+         // the first fact is delivered, the second is still pending at teardown.
+         std::vector<vm::tuple*> released;
+         vm::candidate_gc_nodes gc_nodes;
+         auto release([&](sched::delayed_fact *f) {
+            released.push_back(f->tpl);
+            vm::tuple::destroy(f->tpl, f->pred, &alloc, gc_nodes);
+            mem::allocator<sched::delayed_fact>().deallocate(f, 1);
+         });
+         w.expire(delays[0], release);
+         CPPUNIT_ASSERT(released.size() == 1);
+         CPPUNIT_ASSERT(w.size() == 1);
+         w.destroy(release);
+         CPPUNIT_ASSERT(released.size() == 2);
+         CPPUNIT_ASSERT(released[0] == tpls[0]);
+         CPPUNIT_ASSERT(released[1] == tpls[1]);
+         CPPUNIT_ASSERT(gc_nodes.empty());
+         CPPUNIT_ASSERT(w.empty());
+         for(size_t level(0); level < TIMER_WHEEL_LEVELS; ++level)
+            CPPUNIT_ASSERT(w.count(level) == 0);
+         delete pred;
+      }
+
+      CPPUNIT_TEST_SUITE(ThreadTimerWheelTests);
+
+      CPPUNIT_TEST(testLevels);
+      CPPUNIT_TEST(testCascade);
+      CPPUNIT_TEST(testOrder);
+      CPPUNIT_TEST(testShortDelay);
+      CPPUNIT_TEST(testDestroyPending);
+      CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ThreadTimerWheelTests);
@@ -13,7 +13,13 @@ using namespace CppUnit;
 #include "vm/all.hpp"
 #include "vm/bitmap_tests.cpp"
 #include "db/trie_tests.cpp"
+#include "db/array_tests.cpp"
 #include "external/tests.cpp"
+#include "thread/termination_tests.cpp"
+#include "runtime/refcount_tests.cpp"
+#include "thread/partition_tests.cpp"
+#include "queue/bucket_tests.cpp"
+#include "thread/timer_wheel_tests.cpp"
 
 int
 main(int argc, char **argv)
@@ -2,7 +2,9 @@
 #include <fstream>
 #include <iostream>
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 
 #include "utils/fs.hpp"
 
@@ -38,4 +40,28 @@ file_exists(const string& filename)
 	return S_ISREG(info.st_mode);
 }
 
-}
\ No newline at end of file
+mapped_file::mapped_file(const string& filename)
+{
+   const int fd(open(filename.c_str(), O_RDONLY));
+   if(fd < 0)
+      return;
+
+   struct stat info;
+   if(fstat(fd, &info) == 0 && info.st_size > 0) {
+      void *p(mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0));
+      if(p != MAP_FAILED) {
+         start = (utils::byte*)p;
+         length = (size_t)info.st_size;
+      }
+   }
+   // the mapping remains valid after the descriptor is closed.
+   close(fd);
+}
+
+mapped_file::~mapped_file(void)
+{
+   if(start)
+      munmap(start, length);
+}
+
+}
@@ -4,12 +4,38 @@
 
 #include <string>
 
+#include "utils/types.hpp"
+
 namespace utils
 {
 
 void file_print_and_remove(const std::string&);
 bool file_exists(const std::string&);
 
+// read-only view of a whole file mapped into memory.
+// pages are shared with the page cache and with
+// other processes mapping the same file.
+class mapped_file
+{
+   private:
+
+      utils::byte *start{nullptr};
+      size_t length{0};
+
+   public:
+
+      inline bool is_open(void) const { return start != nullptr; }
+      inline const utils::byte *data(void) const { return start; }
+      inline size_t size(void) const { return length; }
+
+      explicit mapped_file(const std::string&);
+
+      mapped_file(const mapped_file&) = delete;
+      mapped_file& operator=(const mapped_file&) = delete;
+
+      ~mapped_file(void);
+};
+
 }
 
 #endif
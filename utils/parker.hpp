@@ -0,0 +1,110 @@
+
+#ifndef UTILS_PARKER_HPP
+#define UTILS_PARKER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <time.h>
+#else
+#include <mutex>
+#include <condition_variable>
+#endif
+
+namespace utils
+{
+
+// Lets a thread block until another thread calls unpark.
+// Only parked threads are woken up, calls to unpark while the thread is
+// running do nothing and cost a single load.
+// On Linux the thread sleeps on a futex.
+class parker
+{
+private:
+
+#define PARKER_EMPTY 0
+#define PARKER_NOTIFIED 1
+#define PARKER_PARKED -1
+
+   std::atomic<int32_t> state{PARKER_EMPTY};
+   // time of the last unpark that found the thread parked.
+   std::atomic<int64_t> notified_at{0};
+
+#ifndef __linux__
+   std::mutex mtx;
+   std::condition_variable cv;
+#endif
+
+   static inline int64_t now_ns(void)
+   {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+   }
+
+   inline void wait(const std::chrono::microseconds timeout)
+   {
+#ifdef __linux__
+      struct timespec ts;
+      ts.tv_sec = timeout.count() / 1000000;
+      ts.tv_nsec = (timeout.count() % 1000000) * 1000;
+      syscall(SYS_futex, (int32_t*)&state, FUTEX_WAIT_PRIVATE, PARKER_PARKED, &ts, nullptr, 0);
+#else
+      std::unique_lock<std::mutex> l(mtx);
+      cv.wait_for(l, timeout, [this]() { return state.load() != PARKER_PARKED; });
+#endif
+   }
+
+   inline void wake(void)
+   {
+#ifdef __linux__
+      syscall(SYS_futex, (int32_t*)&state, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+      std::lock_guard<std::mutex> l(mtx);
+      cv.notify_one();
+#endif
+   }
+
+public:
+
+   static_assert(sizeof(std::atomic<int32_t>) == sizeof(int32_t),
+         "futex needs a plain 32 bit word.");
+
+   inline bool is_parked(void) const { return state.load() == PARKER_PARKED; }
+
+   // blocks until unpark is called or the timeout expires.
+   // 'idle' is checked again once the thread is marked as parked so that
+   // work added before unpark looked at the state is not missed.
+   // returns the time in nanoseconds between unpark and the thread
+   // running again, or -1 if the thread was not woken by unpark.
+   template <typename F>
+   inline int64_t park(const std::chrono::microseconds timeout, F idle)
+   {
+      state.store(PARKER_PARKED);
+      if(!idle()) {
+         state.store(PARKER_EMPTY);
+         return -1;
+      }
+      wait(timeout);
+      if(state.exchange(PARKER_EMPTY) == PARKER_NOTIFIED)
+         return now_ns() - notified_at.load(std::memory_order_relaxed);
+      return -1;
+   }
+
+   inline void unpark(void)
+   {
+      if(state.load() != PARKER_PARKED)
+         return;
+      notified_at.store(now_ns(), std::memory_order_relaxed);
+      int32_t expected(PARKER_PARKED);
+      if(state.compare_exchange_strong(expected, PARKER_NOTIFIED))
+         wake();
+   }
+};
+
+}
+
+#endif
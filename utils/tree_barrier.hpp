@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <assert.h>
 #include <atomic>
+#include <sched.h>
 
 #include "utils/utils.hpp"
 
@@ -34,6 +35,17 @@ private:
          children_count = n;
       }
       
+// spins before giving away the cpu, there may be more threads than cpus.
+#define TREE_BARRIER_SPINS 1024
+      template <typename F>
+      static inline void spin_until(F done)
+      {
+         for(size_t i(0); !done(); ++i) {
+            if(i >= TREE_BARRIER_SPINS)
+               sched_yield();
+         }
+      }
+
       inline void wait(void)
       {
          bool my_sense(thread_sense);
@@ -41,14 +53,14 @@ private:
          if(id == 0)
             assert(parent == nullptr);
          
-         while(children_count > 0) {}
+         spin_until([this]() { return children_count == 0; });
          
          children_count = count;
          
          if(parent != nullptr) {
             // not root
             parent->children_count--;
-            while(outer->sense != my_sense) {}
+            spin_until([this, my_sense]() { return outer->sense == my_sense; });
          } else {
             // root
             outer->sense = !outer->sense;
@@ -2,8 +2,13 @@
 #include <iostream>
 #include <fstream>
 #include <random>
+#include <algorithm>
 #include <unistd.h>
 #include <assert.h>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 #include "utils/utils.hpp"
 #include "utils/random.hpp"
@@ -27,6 +32,49 @@ number_cpus(void)
 	  return (size_t)sysconf(_SC_NPROCESSORS_ONLN);
 }
 
+size_t
+cpu_socket(const size_t cpu)
+{
+   ifstream fp("/sys/devices/system/cpu/cpu" + to_string(cpu) +
+         "/topology/physical_package_id");
+   int socket(0);
+
+   if(!(fp >> socket) || socket < 0)
+      return 0;
+   return (size_t)socket;
+}
+
+vector<size_t>
+cpus_by_socket(void)
+{
+   const size_t n(number_cpus());
+   vector<pair<size_t, size_t>> sockets;
+
+   for(size_t i(0); i < n; ++i)
+      sockets.push_back(make_pair(cpu_socket(i), i));
+   stable_sort(sockets.begin(), sockets.end());
+
+   vector<size_t> ret;
+   for(const auto & p : sockets)
+      ret.push_back(p.second);
+   return ret;
+}
+
+bool
+pin_current_thread(const size_t cpu)
+{
+#ifdef __linux__
+   cpu_set_t set;
+
+   CPU_ZERO(&set);
+   CPU_SET(cpu, &set);
+   return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) == 0;
+#else
+   (void)cpu;
+   return false;
+#endif
+}
+
 size_t
 random_unsigned(const size_t lim)
 {
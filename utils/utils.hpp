@@ -25,6 +25,12 @@ namespace utils {
 
 void set_random_generator(randgen *);
 size_t number_cpus(void);
+// socket (physical package) of a given cpu.
+size_t cpu_socket(const size_t);
+// online cpus ordered by socket.
+std::vector<size_t> cpus_by_socket(void);
+// pins the calling thread to the given cpu.
+bool pin_current_thread(const size_t);
 
 template <typename T>
 std::string to_string(const T& obj) {
@@ -1,9 +1,9 @@
-
 #ifndef VM_BUFFER_HPP
 #define VM_BUFFER_HPP
 
-#include <unordered_map>
-#include <map>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
 
 #include "db/node.hpp"
 #include "mem/allocator.hpp"
@@ -13,29 +13,74 @@ namespace vm
 {
 
 struct buffer_pair {
-   db::node *node;
+   db::node *node{nullptr};
    buffer_node b;
 };
 
+// facts sent to several nodes owned by the same thread.
+// the receiver unpacks the batch and delivers the facts to its nodes.
+struct thread_batch {
+   thread_batch *next{nullptr};
+   std::vector<buffer_pair, mem::allocator<buffer_pair>> nodes;
+
+   // takes the facts of 'from', which is left empty.
+   inline void add(buffer_pair &from)
+   {
+      nodes.emplace_back();
+      buffer_pair &p(nodes.back());
+      p.node = from.node;
+      p.b.ls.swap(from.b.ls);
+   }
+
+   static inline thread_batch *create(void)
+   {
+      thread_batch *batch(mem::allocator<thread_batch>().allocate(1));
+      mem::allocator<thread_batch>().construct(batch);
+      return batch;
+   }
+
+   static inline void destroy(thread_batch *batch)
+   {
+      mem::allocator<thread_batch>().destroy(batch);
+      mem::allocator<thread_batch>().deallocate(batch, 1);
+   }
+};
+
+// Facts to send at the end of a node run, grouped by target node.
+// Nodes are found with an open addressing table that stores indexes
+// into 'nodes', which keeps the nodes in insertion order.
 struct buffer
 {
-#if 0
-   using map_sends = std::unordered_map<const db::node*, buffer_node,
-         db::node_hash,
-         std::equal_to<const db::node*>,
-         mem::allocator<std::pair<const db::node* const, buffer_node>>>;
-#endif
-   using map_sends = std::map<const db::node*, buffer_node,
-         std::less<const db::node*>,
-         mem::allocator<std::pair<const db::node* const, buffer_node>>>;
+#define VM_BUFFER_INITIAL_SLOTS 16
+// nodes delivered in insertion order, the others are delivered by address.
+#define VM_BUFFER_ORDERED 8
 
-#define MAX_VM_BUFFER 8
+   std::vector<buffer_pair, mem::allocator<buffer_pair>> nodes;
+   // number of entries of 'nodes' in use, the others are kept for reuse.
+   size_t used{0};
+   // index + 1 of the node in 'nodes' or 0 if the slot is empty.
+   std::vector<uint32_t, mem::allocator<uint32_t>> slots;
 
-   buffer_pair initial[MAX_VM_BUFFER];
-   size_t size_initial{0};
-   map_sends facts;
+   static inline size_t hash_node(const db::node *n)
+   {
+      return (size_t)(((uintptr_t)n >> 4) * 0x9E3779B97F4A7C15ULL >> 32);
+   }
 
-   inline bool lots_of_nodes() const { return size_initial == MAX_VM_BUFFER; }
+   inline size_t find_slot(const db::node *n) const
+   {
+      const size_t mask(slots.size() - 1);
+      size_t i(hash_node(n) & mask);
+      while(slots[i] && nodes[slots[i] - 1].node != n)
+         i = (i + 1) & mask;
+      return i;
+   }
+
+   inline void grow(void)
+   {
+      slots.assign(slots.size() * 2, 0);
+      for(size_t i(0); i < used; ++i)
+         slots[find_slot(nodes[i].node)] = i + 1;
+   }
 
    inline void add_into_buffer_node(buffer_node &bn, vm::tuple *tpl, vm::predicate *pred)
    {
@@ -54,39 +99,43 @@ struct buffer
    inline void add(db::node *n, vm::tuple *tpl, vm::predicate *pred) __attribute__((always_inline))
    {
       assert(n);
-      for(size_t i(0); i < size_initial; ++i) {
-         assert(initial[i].node);
-         if(initial[i].node == n) {
-            buffer_node &bn(initial[i].b);
-            add_into_buffer_node(bn, tpl, pred);
-            return;
-         }
-      }
-      if(lots_of_nodes()) {
-         auto it(facts.find(n));
-         if(it == facts.end()) {
-            auto i(facts.insert(std::make_pair(n, buffer_node())));
-            it = i.first;
-         }
-         buffer_node& bn(it->second);
-         add_into_buffer_node(bn, tpl, pred);
-      } else {
-         // add new initial
-         const size_t idx(size_initial);
-         size_initial++;
-         initial[idx].node = n;
-         buffer_node &bn(initial[idx].b);
-         bn.clear();
-         add_into_buffer_node(bn, tpl, pred);
+      if(slots.empty())
+         slots.assign(VM_BUFFER_INITIAL_SLOTS, 0);
+      const size_t i(find_slot(n));
+      if(slots[i]) {
+         add_into_buffer_node(nodes[slots[i] - 1].b, tpl, pred);
+         return;
       }
+      if(used == nodes.size())
+         nodes.emplace_back();
+      buffer_pair &p(nodes[used++]);
+      p.node = n;
+      p.b.clear();
+      add_into_buffer_node(p.b, tpl, pred);
+      slots[i] = used;
+      if(used * 2 > slots.size())
+         grow();
    }
 
-   inline void clear()
+   // empties the table and puts the nodes in delivery order.
+   // no facts can be added until clear() is called.
+   inline void prepare_send()
    {
-      if(lots_of_nodes())
-         facts.clear();
-      size_initial = 0;
+      // only empty the slots in use since the table may be large.
+      const size_t mask(slots.size() - 1);
+      for(size_t k(0); k < used; ++k) {
+         size_t i(hash_node(nodes[k].node) & mask);
+         while(slots[i] != k + 1)
+            i = (i + 1) & mask;
+         slots[i] = 0;
+      }
+      if(used > VM_BUFFER_ORDERED) {
+         std::sort(nodes.begin() + VM_BUFFER_ORDERED, nodes.begin() + used,
+               [](const buffer_pair& a, const buffer_pair& b) { return a.node < b.node; });
+      }
    }
+
+   inline void clear() { used = 0; }
 };
 
 }
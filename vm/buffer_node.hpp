@@ -38,6 +38,27 @@ struct buffer_node {
       ls.reserve(8);
    }
 };
+
+// batch of facts sent to a node owned by another thread.
+struct buffer_batch {
+   buffer_batch *next{nullptr};
+   buffer_node b;
+
+   // takes the contents of 'from', which is left empty.
+   static inline buffer_batch *create(buffer_node &from)
+   {
+      buffer_batch *batch(mem::allocator<buffer_batch>().allocate(1));
+      mem::allocator<buffer_batch>().construct(batch);
+      batch->b.ls.swap(from.ls);
+      return batch;
+   }
+
+   static inline void destroy(buffer_batch *batch)
+   {
+      mem::allocator<buffer_batch>().destroy(batch);
+      mem::allocator<buffer_batch>().deallocate(batch, 1);
+   }
+};
 }
 
 #endif
@@ -620,7 +620,11 @@ static inline return_type execute_pers_iter(const reg_num reg, match* m,
 
    if(pred->is_compact_pred()) {
       db::array *a(node->pers_store.get_array(pred));
-      for(auto it(a->begin(pred)), end(a->end(pred)); it != end; ++it) {
+      if(!a->frozen) a->freeze(pred);
+      auto it(a->begin(pred)), end(a->end(pred));
+      if(m && a->has_order() && m->has_match(0))
+         std::tie(it, end) = a->equal_range(pred, m->get_match(0).field);
+      for(; it != end; ++it) {
          vm::tuple *match_tuple(*it);
          if(!do_matches(m, match_tuple, pred))
             continue;
@@ -673,6 +677,36 @@ static inline return_type execute_pers_iter(const reg_num reg, match* m,
    return RETURN_NO_RETURN;
 }
 
+static inline uint64_t match_column_block(const column_store* cs,
+                                          const size_t block, match* m,
+                                          state& state, predicate* pred,
+                                          uint64_t& seen) {
+#ifdef CORE_STATISTICS
+   execution_time::scope s(state.stat.ts_search_time_predicate[pred->get_id()]);
+#else
+   (void)state;
+#endif
+   return cs->match_block(block, m, pred, seen);
+}
+
+static inline void collect_column_tuples(vector_iter& tpls, column_store* cs,
+                                         const reg_num reg, match* m,
+                                         state& state, predicate* pred) {
+   for (size_t block(0); block < cs->end_row(); block += COLUMN_STORE_BITS) {
+      uint64_t seen(0);
+      for (uint64_t mask(cs->match_block(block, m, pred, seen)); mask;
+           mask &= mask - 1) {
+         tuple* tpl(cs->get_tuple(block + __builtin_ctzll(mask)));
+         if (!state.tuple_is_used(tpl, reg)) {
+            iter_object obj;
+            obj.tpl = tpl;
+            obj.ls = nullptr;
+            tpls.push_back(obj);
+         }
+      }
+   }
+}
+
 static inline return_type execute_olinear_iter(const reg_num reg, match* m,
                                                const pcounter pc,
                                                const pcounter first,
@@ -686,21 +720,26 @@ static inline return_type execute_olinear_iter(const reg_num reg, match* m,
 
    vector_iter tpls;
 
-   utils::intrusive_list<vm::tuple>* local_tuples(
-       node->linear.get_linked_list(pred->get_linear_id()));
 #ifdef CORE_STATISTICS
    execution_time::scope s(state.stat.ts_search_time_predicate[pred->get_id()]);
 #endif
-   for (utils::intrusive_list<vm::tuple>::iterator it(local_tuples->begin()),
-        end(local_tuples->end());
-        it != end; ++it) {
-      tuple* tpl(*it);
-      if (!state.tuple_is_used(tpl, reg) && do_matches(m, tpl, pred)) {
-         iter_object obj;
-         obj.tpl = tpl;
-         obj.iterator = it;
-         obj.ls = local_tuples;
-         tpls.push_back(obj);
+   if (node->linear.stored_as_columns(pred))
+      collect_column_tuples(tpls, node->linear.get_column_store(pred->get_linear_id()),
+                            reg, m, state, pred);
+   else {
+      utils::intrusive_list<vm::tuple>* local_tuples(
+          node->linear.get_linked_list(pred->get_linear_id()));
+      for (utils::intrusive_list<vm::tuple>::iterator it(local_tuples->begin()),
+           end(local_tuples->end());
+           it != end; ++it) {
+         tuple* tpl(*it);
+         if (!state.tuple_is_used(tpl, reg) && do_matches(m, tpl, pred)) {
+            iter_object obj;
+            obj.tpl = tpl;
+            obj.iterator = it;
+            obj.ls = local_tuples;
+            tpls.push_back(obj);
+         }
       }
    }
 
@@ -730,8 +769,11 @@ static inline return_type execute_olinear_iter(const reg_num reg, match* m,
       POP_STATE();
 
       if (TO_FINISH(ret)) {
-         utils::intrusive_list<vm::tuple>::iterator it(p.iterator);
-         ls->erase(it);
+         if (ls) {
+            utils::intrusive_list<vm::tuple>::iterator it(p.iterator);
+            ls->erase(it);
+         } else
+            node->linear.get_column_store(pred->get_linear_id())->remove(match_tuple, pred);
          vm::tuple::destroy(match_tuple, pred, &(node->alloc), state.gc_nodes);
          if (ret == RETURN_LINEAR) return RETURN_LINEAR;
          if (ret == RETURN_DERIVED && old_is_linear) return RETURN_DERIVED;
@@ -757,20 +799,25 @@ static inline return_type execute_orlinear_iter(const reg_num reg, match* m,
 
    vector_iter tpls;
 
-   utils::intrusive_list<vm::tuple>* local_tuples(
-       node->linear.get_linked_list(pred->get_linear_id()));
 #ifdef CORE_STATISTICS
    execution_time::scope s(state.stat.ts_search_time_predicate[pred->get_id()]);
 #endif
-   for (utils::intrusive_list<vm::tuple>::iterator it(local_tuples->begin()),
-        end(local_tuples->end());
-        it != end; ++it) {
-      tuple* tpl(*it);
-      if (!state.tuple_is_used(tpl, reg) && do_matches(m, tpl, pred)) {
-         iter_object obj;
-         obj.tpl = tpl;
-         obj.iterator = it;
-         tpls.push_back(obj);
+   if (node->linear.stored_as_columns(pred))
+      collect_column_tuples(tpls, node->linear.get_column_store(pred->get_linear_id()),
+                            reg, m, state, pred);
+   else {
+      utils::intrusive_list<vm::tuple>* local_tuples(
+          node->linear.get_linked_list(pred->get_linear_id()));
+      for (utils::intrusive_list<vm::tuple>::iterator it(local_tuples->begin()),
+           end(local_tuples->end());
+           it != end; ++it) {
+         tuple* tpl(*it);
+         if (!state.tuple_is_used(tpl, reg) && do_matches(m, tpl, pred)) {
+            iter_object obj;
+            obj.tpl = tpl;
+            obj.iterator = it;
+            tpls.push_back(obj);
+         }
       }
    }
 
@@ -956,10 +1003,70 @@ static inline return_type execute_linear_iter_list(
    return RETURN_NO_RETURN;
 }
 
+static inline return_type execute_linear_iter_columns(
+    db::node *node, const reg_num reg, match* m, const pcounter first, state& state,
+    predicate* pred, column_store* cs) {
+   const bool old_is_linear(state.is_linear);
+   const bool this_is_linear(true);
+   const depth_t old_depth(state.depth);
+
+   // the end is read again after each block since rules may add facts to the store.
+   for (size_t block(0); block < cs->end_row(); block += COLUMN_STORE_BITS) {
+      uint64_t seen(0);
+      uint64_t mask(0);
+      while (mask || (mask = match_column_block(cs, block, m, state, pred, seen))) {
+         const size_t row(block + __builtin_ctzll(mask));
+         mask &= mask - 1;
+         // the tuple may have been removed by a previous rule.
+         if (!cs->is_used(row, pred))
+            continue;
+         tuple* match_tuple(cs->get_tuple(row));
+
+         if(state.tuple_is_used(match_tuple, reg))
+            continue;
+
+         PUSH_CURRENT_STATE(match_tuple, nullptr, match_tuple, (vm::depth_t)0);
+#ifdef DEBUG_ITERS
+         cout << "\titerate ";
+         match_tuple->print(cout, pred);
+         cout << "\n";
+#endif
+
+         const return_type ret(execute(first, state, reg, match_tuple, pred));
+
+         POP_STATE();
+
+         if (TO_FINISH(ret)) {
+            if(state.updated_map.get_bit(reg)) {
+               state.updated_map.unset_bit(reg);
+               if (reg > 0) {
+                  cs->remove(match_tuple, pred);
+                  state.add_generated(match_tuple, pred);
+               } else
+                  // the tuple stays in place with new values.
+                  cs->update(match_tuple, pred);
+            } else {
+               cs->remove(match_tuple, pred);
+               vm::tuple::destroy(match_tuple, pred, &(node->alloc), state.gc_nodes);
+               if (cs->empty())
+                  state.matcher->empty_predicate(pred->get_id());
+            }
+         }
+
+         if (ret == RETURN_LINEAR) return RETURN_LINEAR;
+         if (old_is_linear && ret == RETURN_DERIVED) return RETURN_DERIVED;
+      }
+   }
+   return RETURN_NO_RETURN;
+}
+
 static inline return_type execute_linear_iter(const reg_num reg, match* m,
                                               const pcounter first,
                                               state& state, predicate* pred,
                                               db::node* node) {
+   if (node->linear.stored_as_columns(pred))
+      return execute_linear_iter_columns(node, reg, m, first, state, pred,
+            node->linear.get_column_store(pred->get_linear_id()));
    if (node->linear.stored_as_hash_table(pred)) {
       const field_num hashed(pred->get_hashed_field());
       hash_table* table(node->linear.get_hash_table(pred->get_linear_id()));
@@ -1030,10 +1137,51 @@ static inline return_type execute_rlinear_iter_list(
    return RETURN_NO_RETURN;
 }
 
+static inline return_type execute_rlinear_iter_columns(
+    const reg_num reg, match* m, const pcounter first, state& state,
+    predicate* pred, column_store* cs) {
+   const bool old_is_linear(state.is_linear);
+   const bool this_is_linear(false);
+   const depth_t old_depth(state.depth);
+
+   for (size_t block(0); block < cs->end_row(); block += COLUMN_STORE_BITS) {
+      uint64_t seen(0);
+      uint64_t mask(0);
+      while (mask || (mask = match_column_block(cs, block, m, state, pred, seen))) {
+         const size_t row(block + __builtin_ctzll(mask));
+         mask &= mask - 1;
+         if (!cs->is_used(row, pred))
+            continue;
+         vm::tuple *match_tuple(cs->get_tuple(row));
+         if(state.tuple_is_used(match_tuple, reg))
+            continue;
+
+         PUSH_CURRENT_STATE(match_tuple, nullptr, match_tuple, (vm::depth_t)0);
+#ifdef DEBUG_ITERS
+         cout << "\titerate ";
+         match_tuple->print(cout, pred);
+         cout << "\n";
+#endif
+
+         const return_type ret(execute(first, state, reg, match_tuple, pred));
+
+         POP_STATE();
+
+         if (ret == RETURN_LINEAR) return RETURN_LINEAR;
+         if (old_is_linear && ret == RETURN_DERIVED) return RETURN_DERIVED;
+      }
+   }
+
+   return RETURN_NO_RETURN;
+}
+
 static inline return_type execute_rlinear_iter(const reg_num reg, match* m,
                                                const pcounter first,
                                                state& state, predicate* pred,
                                                db::node* node) {
+   if (node->linear.stored_as_columns(pred))
+      return execute_rlinear_iter_columns(reg, m, first, state, pred,
+            node->linear.get_column_store(pred->get_linear_id()));
    if (node->linear.stored_as_hash_table(pred)) {
       const field_num hashed(pred->get_hashed_field());
       hash_table* table(node->linear.get_hash_table(pred->get_linear_id()));
@@ -1672,6 +1820,32 @@ static inline bool perform_remote_update(
    return false;
 }
 
+static inline bool perform_remote_update_columns(
+    column_store* cs, predicate* pred_target, const size_t common,
+    tuple_field* regs) {
+   for (size_t row(cs->next_row(0, pred_target)); row < cs->end_row();
+        row = cs->next_row(row + 1, pred_target)) {
+      for (size_t i(0); i < common; ++i) {
+         vm::type* t(pred_target->get_field_type(i));
+         match_field m = {true, t, regs[i]};
+         if (!do_rec_match(m, cs->get_field(row, i), t)) goto continue2;
+      }
+
+      {
+         // columnar predicates do not have reference fields.
+         vm::tuple* match_tuple(cs->get_tuple(row));
+         for (size_t i(common); i < pred_target->num_fields(); ++i)
+            tuple_set_field(match_tuple, pred_target->get_field_type(i), i, regs[i]);
+         cs->update(match_tuple, pred_target);
+      }
+      return true;
+
+   continue2:
+      continue;
+   }
+   return false;
+}
+
 static inline void execute_remote_update(pcounter& pc, state& state) {
    const reg_num dest(remote_update_dest(pc));
    const predicate_id edit(remote_update_edit(pc));
@@ -1695,7 +1869,11 @@ static inline void execute_remote_update(pcounter& pc, state& state) {
    bool updated{false};
    LOCK_STACK(internal_lock_data);
    if (n->database_lock.try_lock1(LOCK_STACK_USE(internal_lock_data))) {
-      if (n->linear.stored_as_hash_table(pred_target)) {
+      if (n->linear.stored_as_columns(pred_target))
+         updated = perform_remote_update_columns(
+             n->linear.get_column_store(pred_target->get_linear_id()),
+             pred_target, common, regs);
+      else if (n->linear.stored_as_hash_table(pred_target)) {
          const field_num h(pred_target->get_hashed_field());
          hash_table* table(
              n->linear.get_hash_table(pred_target->get_linear_id()));
@@ -2449,7 +2627,7 @@ static inline return_type execute(pcounter pc, state& state, const reg_num reg,
       state.preds[reg] = pred;
 #ifdef CORE_STATISTICS
       state.stat.stat_tuples_used++;
-      if (tpl->is_linear()) {
+      if (pred->is_linear_pred()) {
          state.stat.stat_predicate_applications[pred->get_id()]++;
       }
 #endif
@@ -3143,7 +3321,7 @@ static inline return_type execute(pcounter pc, state& state, const reg_num reg,
    CASE(MVTHREADIDREG_INSTR)
    JUMP(mvthreadidreg, MVTHREADIDREG_BASE)
 #ifdef CORE_STATISTICS
-   state.state.stat_moves_executed++;
+   state.stat.stat_moves_executed++;
 #endif
    execute_mvthreadidreg(pc, state);
    ADVANCE()
@@ -292,6 +292,7 @@ static inline void add_new_axioms(state &state, db::node *node, pcounter pc,
                tuple_set_field(tpl, pred->get_field_type(i), i, field);
             }
          }
+         s->freeze(pred);
          state.matcher->new_persistent_fact(pred->get_id());
       } else {
          for (size_t j(0); j < num; ++j) {
@@ -184,6 +184,25 @@ predicate* predicate::make_predicate_from_reader(
       }
    }
 
+#if defined(COLUMNAR_STORE) && !defined(COMPILED) && !defined(DYNAMIC_INDEXING)
+   // linear facts with only scalar arguments are stored by columns.
+   if (pred->is_linear && !pred->is_hash_table() && pred->num_fields() > 0) {
+      bool scalar(true);
+      for (size_t i(0); i < pred->num_fields(); ++i) {
+         switch (pred->types[i]->get_type()) {
+            case FIELD_INT:
+            case FIELD_FLOAT:
+            case FIELD_NODE:
+               break;
+            default:
+               scalar = false;
+               break;
+         }
+      }
+      if (scalar) pred->store_as_columns();
+   }
+#endif
+
    // read predicate name
    char name_buf[PRED_NAME_SIZE_MAX];
    read.read_any(name_buf, PRED_NAME_SIZE_MAX);
@@ -298,6 +317,7 @@ void predicate::print(ostream& cout) const {
    if (is_cycle) cout << ",cycle";
    if (is_thread) cout << ",thread";
    if (is_compact) cout << ",compact";
+   if (is_columnar()) cout << ",columns";
 
    cout << "]";
 
@@ -4,6 +4,7 @@
 
 #include <string>
 #include <vector>
+#include <atomic>
 #include <assert.h>
 
 #include "vm/types.hpp"
@@ -21,7 +22,7 @@ const size_t PRED_AGG_INFO_MAX = 32;
 
 class program;
 
-typedef enum { LINKED_LIST, HASH_TABLE } store_type_t;
+typedef enum { LINKED_LIST, HASH_TABLE, COLUMNS } store_type_t;
 
 class rule;
 
@@ -72,6 +73,13 @@ struct predicate {
    store_type_t store_type;
    field_num hash_argument;
 
+#ifdef FACT_STATISTICS
+   // number of times a node turned the facts of this predicate
+   // from a list into a hash table and back.
+   mutable std::atomic<uint64_t> stat_to_hash_table{0};
+   mutable std::atomic<uint64_t> stat_to_list{0};
+#endif
+
    // index of this predicate's arguments in the whole set of program's
    // predicates
    size_t argument_position;
@@ -166,6 +174,9 @@ struct predicate {
 
    inline bool is_hash_table(void) const { return store_type == HASH_TABLE; }
 
+   inline void store_as_columns(void) { store_type = COLUMNS; }
+   inline bool is_columnar(void) const { return store_type == COLUMNS; }
+
    inline void set_argument_position(const size_t arg) {
       argument_position = arg;
    }
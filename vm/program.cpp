@@ -44,16 +44,20 @@ program::program() {
 #endif
 }
 
-std::unique_ptr<ifstream> program::bypass_bytecode_header(
-    const string& filename) {
-   std::unique_ptr<ifstream> fp(
-       new ifstream(filename.c_str(), ios::in | ios::binary));
-
-   fp->seekg(vm::MAGIC_SIZE, ios_base::cur);        // skip magic
-   fp->seekg(2 * sizeof(uint32_t), ios_base::cur);  // skip version
-
-   fp->seekg(sizeof(byte), ios_base::cur);  // skip number of definitions
-   return fp;
+const utils::byte *program::bypass_bytecode_header(const mapped_file &fp) {
+   const size_t header(vm::MAGIC_SIZE +          // skip magic
+                       2 * sizeof(uint32_t) +    // skip version
+                       sizeof(byte));            // skip number of definitions
+
+   int_val num_nodes;
+
+   if (fp.size() < header + sizeof(int_val)) return nullptr;
+   memcpy(&num_nodes, fp.data() + header, sizeof(int_val));
+   if (num_nodes < 0 ||
+       fp.size() < header + sizeof(int_val) +
+                       (size_t)num_nodes * database::node_size)
+      return nullptr;
+   return fp.data() + header;
 }
 
 #ifndef COMPILED
@@ -82,8 +86,11 @@ static inline ptr_val get_function_pointer(char* lib_path, char* func_name) {
 }
 
 program::program(string _filename)
+    : program(mapped_file(_filename), _filename) {}
+
+program::program(const mapped_file& file, string _filename)
     : filename(std::move(_filename)), init(nullptr) {
-   code_reader read(filename);
+   code_reader read(file, filename);
 
    // read magic
    uint32_t magic1, magic2;
@@ -342,6 +349,7 @@ program::program(string _filename)
       if (pred->is_linear_pred()) {
          pred->id2 = num_linear_predicates();
          linear_predicates.push_back(pred);
+         if (pred->is_columnar()) columnar_predicates.push_back(pred);
       } else {
          pred->id2 = num_persistent_predicates();
          persistent_predicates.push_back(pred);
@@ -662,6 +670,90 @@ predicate* program::get_edge_predicate(void) const {
    return get_predicate_by_name("edge");
 }
 
+#ifndef COMPILED
+static inline void skip_axiom_data(pcounter& pc, const type* t) {
+   switch (t->get_type()) {
+      case FIELD_INT:
+         pcounter_move_int(&pc);
+         break;
+      case FIELD_FLOAT:
+         pcounter_move_float(&pc);
+         break;
+      case FIELD_NODE:
+         pcounter_move_node(&pc);
+         break;
+      case FIELD_LIST:
+         // a list is a sequence of 1 + head ended by a 0.
+         while (*pc++ == 1)
+            skip_axiom_data(pc, ((const list_type*)t)->get_subtype());
+         break;
+      case FIELD_STRUCT: {
+         const struct_type* st((const struct_type*)t);
+         for (size_t i(0); i < st->get_size(); ++i)
+            skip_axiom_data(pc, st->get_type(i));
+      } break;
+      default:
+         abort();
+   }
+}
+
+static inline void read_edge_new_axioms(const node_val node, pcounter pc,
+      const pcounter end, const program* prog, const predicate* edge,
+      vector<pair<node_val, node_val>>& edges) {
+   while (pc < end) {
+      const uint_val num(pcounter_int(pc));
+      pcounter_move_int(&pc);
+      const predicate* pred(prog->get_predicate(predicate_get(pc, 0)));
+      pcounter_move_byte(&pc);
+      for (size_t j(0); j < num; ++j) {
+         for (size_t i(0); i < pred->num_fields(); ++i) {
+            if (pred == edge && i == 0)
+               edges.push_back(make_pair(node, pcounter_node(pc)));
+            skip_axiom_data(pc, pred->get_field_type(i));
+         }
+      }
+   }
+}
+
+void program::read_edge_axioms(vector<pair<node_val, node_val>>& edges) const {
+   const predicate* edge(get_edge_predicate());
+   if (edge == nullptr || edge->num_fields() == 0 ||
+       edge->get_field_type(0)->get_type() != FIELD_NODE)
+      return;
+
+   // the axioms of each node are in the SELECT instruction of the rule
+   // that consumes the init fact.
+   pcounter pc(nullptr), end(nullptr);
+   for (size_t i(0); i < num_rules() && pc == nullptr; ++i) {
+      const rule* r(get_rule(i));
+      pcounter p(r->get_bytecode());
+      const pcounter e(p + r->get_codesize());
+      while (p < e && fetch(p) != RETURN_INSTR && fetch(p) != SELECT_INSTR)
+         p = advance(p);
+      if (p < e && fetch(p) == SELECT_INSTR) {
+         pc = p;
+         end = e;
+      }
+   }
+   if (pc == nullptr) return;
+
+   const pcounter hash_start(select_hash_start(pc));
+   const size_t hash_size(select_hash_size(pc));
+   for (size_t id(0); id < hash_size; ++id) {
+      const code_offset_t hashed(select_hash(hash_start, id));
+      if (hashed == 0) continue;
+      pcounter p(select_hash_code(hash_start, hash_size, hashed));
+      while (p < end && fetch(p) != RETURN_SELECT_INSTR &&
+             fetch(p) != RETURN_INSTR) {
+         if (fetch(p) == NEW_AXIOMS_INSTR)
+            read_edge_new_axioms((node_val)id, p + NEW_AXIOMS_BASE,
+                                 p + new_axioms_jump(p), this, edge, edges);
+         p = advance(p);
+      }
+   }
+}
+#endif
+
 void program::sort_predicates() {
    sort(sorted_predicates.begin(), sorted_predicates.end(),
         [](predicate* a1, predicate* a2) {
@@ -19,6 +19,7 @@
 #include "vm/bitmap.hpp"
 #include "vm/bitmap_static.hpp"
 #include "vm/special_facts.hpp"
+#include "utils/fs.hpp"
 #ifdef USE_REAL_NODES
 #include <unordered_map>
 #endif
@@ -68,6 +69,8 @@ class program {
    std::vector<predicate *, mem::allocator<predicate *>> predicates;
    std::vector<predicate *, mem::allocator<predicate *>> persistent_predicates;
    std::vector<predicate *, mem::allocator<predicate *>> linear_predicates;
+   // linear predicates stored by columns.
+   std::vector<predicate *, mem::allocator<predicate *>> columnar_predicates;
 
    std::vector<byte_code, mem::allocator<byte_code>> code;
    std::vector<code_size_t, mem::allocator<code_size_t>> code_size;
@@ -220,6 +223,10 @@ class program {
 
    predicate *get_init_thread_predicate(void) const;
    predicate *get_edge_predicate(void) const;
+#ifndef COMPILED
+   // reads the edge axioms of the nodes as (source, target) pairs.
+   void read_edge_axioms(std::vector<std::pair<node_val, node_val>>&) const;
+#endif
 
    inline bool has_thread_predicates() const {
       return !thread_predicates.empty();
@@ -303,11 +310,14 @@ class program {
    void cleanup_node_references() { if(node_references) delete []node_references; }
 #endif
 
-   static std::unique_ptr<std::ifstream> bypass_bytecode_header(
-       const std::string &);
+   // returns the location of the node table of a mapped byte-code file.
+   static const utils::byte *bypass_bytecode_header(
+       const utils::mapped_file &);
 
 #ifndef COMPILED
    explicit program(std::string);
+   // reads the byte-code from a file that is already mapped.
+   explicit program(const utils::mapped_file &, std::string);
 #endif
    explicit program(void);  // add compiled program
 
@@ -4,11 +4,13 @@
 
 // reads byte code files
 
-#include <fstream>
+#include <cstring>
 #include <string>
+#include <stdexcept>
 
 #include "vm/defs.hpp"
 #include "utils/types.hpp"
+#include "utils/fs.hpp"
 
 namespace vm
 {
@@ -24,8 +26,15 @@ class code_reader
 {
    private:
 
-      std::ifstream fp;
-      size_t position;
+      const utils::mapped_file& fp;
+      const std::string filename;
+      size_t position{0};
+
+      inline void check_available(const size_t size) const
+      {
+         if(position + size > fp.size())
+            throw load_file_error(filename, std::string("unexpected end of file"));
+      }
 
    public:
 
@@ -37,7 +46,8 @@ class code_reader
 
       inline void read(utils::byte *out, const size_t size)
       {
-         fp.read((char *)out, size);
+         check_available(size);
+         memcpy(out, fp.data() + position, size);
          position += size;
       }
 
@@ -49,15 +59,16 @@ class code_reader
 
       inline void seek(const size_t size)
       {
-         fp.seekg(size, std::ios_base::cur);
+         check_available(size);
          position += size;
       }
 
-      explicit code_reader(const std::string& file_name):
-            fp(file_name.c_str(), std::ios::in | std::ios::binary)
+      // the mapping must outlive the reader.
+      explicit code_reader(const utils::mapped_file& file, const std::string& file_name):
+            fp(file), filename(file_name)
       {
-         //if(!fp.is_open())
-            //throw load_file_error(file_name, std::string("could not open file"));
+         if(!fp.is_open())
+            throw load_file_error(file_name, std::string("could not open file"));
       }
 };
 
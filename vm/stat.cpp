@@ -1,4 +1,7 @@
 
+#include <iomanip>
+#include <algorithm>
+
 #include "vm/stat.hpp"
 
 using namespace std;
@@ -81,6 +84,10 @@ core_statistics::print(ostream& cout, vm::all *all) const
 		ts_search_time_predicate, all);
 	cout << "=> TOTAL temporary store search time: " << total_ts << endl;
 	
+	const execution_time total_agg = sort_and_print_time_predicates(cout, "Aggregate generation time per predicate",
+		agg_generate_time_predicate, all);
+	cout << "=> TOTAL aggregate generation time: " << total_agg << endl;
+
 	cout << "=> TOTAL temporary store cleanup time: " << clean_temporary_store_time << endl;
 	cout << "=> TOTAL core engine time (calculate rule set): " << core_engine_time << endl;
 	
@@ -126,6 +133,7 @@ core_statistics::core_statistics(vm::all *all)
 	db_deletion_time_predicate.resize(all->PROGRAM->num_predicates());
 	db_search_time_predicate.resize(all->PROGRAM->num_predicates());
 	ts_search_time_predicate.resize(all->PROGRAM->num_predicates());
+	agg_generate_time_predicate.resize(all->PROGRAM->num_predicates());
 }
 
 }
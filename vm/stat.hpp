@@ -48,6 +48,9 @@ class core_statistics {
 		// search time for each predicate
 		std::vector<utils::execution_time> ts_search_time_predicate;
 		
+		// aggregate generation time for each predicate
+		std::vector<utils::execution_time> agg_generate_time_predicate;
+		
 		// time to clean temporary store
 		utils::execution_time clean_temporary_store_time;
 		
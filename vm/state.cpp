@@ -4,6 +4,7 @@
 #include "vm/state.hpp"
 #include "machine.hpp"
 #include "vm/exec.hpp"
+#include "interface.hpp"
 
 using namespace vm;
 using namespace db;
@@ -34,23 +35,11 @@ static enum {
 #endif
 
 void state::purge_runtime_objects(void) {
-   using runtime::array;
-#define PURGE_OBJ_SIMPLE(TYPE)    \
-   for (TYPE * x : free_##TYPE) { \
-      assert(x != nullptr);       \
-      x->dec_refs();              \
-   }                              \
-   free_##TYPE.clear()
-
-   PURGE_OBJ_SIMPLE(rstring);
-   for (auto p : free_cons) p.first->dec_refs(p.second, gc_nodes);
-   free_cons.clear();
-   for (auto p : free_struct1) p.first->dec_refs(p.second, gc_nodes);
-   free_struct1.clear();
-   for (auto p : free_array) p.first->dec_refs(p.second, gc_nodes);
-   free_array.clear();
-   for (auto p : free_set) p.first->dec_refs(p.second, gc_nodes);
-   free_set.clear();
+   // objects whose shared count dropped in other threads.
+   runtime::merge_pending(gc_nodes);
+   for (temp_object& t : temp_objects)
+      runtime::release_object(t.obj, t.kind, t.type, gc_nodes);
+   temp_objects.clear();
 }
 
 void state::cleanup(void)
@@ -213,8 +202,13 @@ void state::add_to_aggregate(db::node *node, vm::full_tuple_list *ls,
 
    full_tuple_list list;
 
-   agg->generate(pred, pred->get_aggregate_type(), pred->get_aggregate_field(),
-                 list, &(node->alloc));
+   {
+#ifdef CORE_STATISTICS
+      execution_time::scope s(stat.agg_generate_time_predicate[pred->get_id()]);
+#endif
+      agg->generate(pred, pred->get_aggregate_type(),
+                    pred->get_aggregate_field(), list, &(node->alloc));
+   }
 
    for (full_tuple_list::iterator it(list.begin()); it != list.end(); ++it) {
       full_tuple *stpl(*it);
@@ -655,6 +649,7 @@ void state::run_node(db::node *node) {
    MUTEX_LOCK(node->database_lock, internal_lock_data, database_lock);
 
    {
+      node->process_inbox();
       process_action_tuples(node);
       process_incoming_tuples(node);
 #if !defined(COMPILED) || defined(COMPILED_DERIVES_PERSISTENT)
@@ -682,6 +677,7 @@ void state::run_node(db::node *node) {
    if (theProgram->has_thread_predicates() && sched->thread_node != node) {
       LOCK_STACK(thread_node_lock);
       MUTEX_LOCK(sched->thread_node->main_lock, thread_node_lock, node_lock);
+      sched->thread_node->process_inbox();
       process_action_tuples(sched->thread_node);
       process_incoming_tuples(sched->thread_node);
       thread_persistent_tuples.splice_back(
@@ -783,23 +779,38 @@ inline bool
 state::sync(db::node *node) {
    bool ret(false);
 #ifdef FACT_BUFFERING
-   // send all facts to nodes.
-   for (size_t i(0); i < facts_to_send.size_initial; ++i) {
-      buffer_node &ls(facts_to_send.initial[i].b);
-      db::node *target(facts_to_send.initial[i].node);
-      assert(target);
-      sched->new_work_list(node, target, ls);
+   // send all facts to nodes. facts for nodes of other threads are
+   // grouped by thread and each thread gets a single batch.
+   if (thread_batches.size() < All->NUM_THREADS)
+      thread_batches.resize(All->NUM_THREADS, nullptr);
+   facts_to_send.prepare_send();
+   for (size_t i(0); i < facts_to_send.used; ++i) {
+      buffer_pair &p(facts_to_send.nodes[i]);
+      assert(p.node);
+      sched::thread *owner(p.node->get_owner());
+      if (node->is_static()) sched->sample_send(node, owner);
+      if (owner == sched && !bsp_mode)
+         sched->new_work_list(node, p.node, p.b);
+      else {
+         const size_t id(owner->get_id());
+         if (!thread_batches[id]) {
+            thread_batches[id] = thread_batch::create();
+            batch_threads.push_back(id);
+         }
+         thread_batches[id]->add(p);
+      }
       ret = true;
    }
-   if (facts_to_send.lots_of_nodes()) {
-      for (auto p : facts_to_send.facts) {
-         buffer_node &ls(p.second);
-         db::node *target((db::node *)p.first);
-         sched->new_work_list(node, target, ls);
-         ret = true;
-      }
+   for (const size_t id : batch_threads) {
+      if (bsp_mode)
+         sched->bsp_send(All->SCHEDS[id], thread_batches[id]);
+      else
+         sched->new_work_batch(All->SCHEDS[id], thread_batches[id]);
+      thread_batches[id] = nullptr;
    }
+   batch_threads.clear();
    facts_to_send.clear();
+   if (node->is_static()) sched->check_node_placement(node);
 #endif
 #ifdef COORDINATION_BUFFERING
    for (auto p : set_priorities) {
@@ -822,7 +833,7 @@ state::state(sched::thread *_sched)
     : sched(_sched)
 #ifdef CORE_STATISTICS
       ,
-      stat()
+      stat(All)
 #endif
 {
 #ifndef COMPILED
@@ -849,7 +860,7 @@ state::state() : state(nullptr) {}
 
 state::~state(void) {
 #ifdef CORE_STATISTICS
-   if (sched != nullptr) stat.print(cout);
+   if (sched != nullptr) stat.print(cout, All);
 #endif
    if (match_counter) {
       // cout << "==================================\n";
@@ -3,6 +3,7 @@
 #define VM_STATE_HPP
 
 #include <list>
+#include <vector>
 #include <unordered_set>
 
 #include "vm/tuple.hpp"
@@ -33,18 +34,15 @@ namespace vm {
 
 struct state {
    private:
-   std::list<std::pair<runtime::cons *, vm::list_type*>, mem::allocator<std::pair<runtime::cons *, vm::list_type*>>> free_cons;
-   std::list<runtime::rstring::ptr, mem::allocator<runtime::rstring::ptr>>
-       free_rstring;
-   std::list<std::pair<runtime::struct1 *, vm::struct_type *>,
-             mem::allocator<std::pair<runtime::struct1 *, vm::struct_type *>>>
-       free_struct1;
-   std::list<std::pair<runtime::array *, vm::type *>,
-             mem::allocator<std::pair<runtime::array *, vm::type *>>>
-       free_array;
-   std::list<std::pair<runtime::set *, vm::type *>,
-             mem::allocator<std::pair<runtime::set *, vm::type *>>>
-       free_set;
+   // runtime objects created while running a node. they are released
+   // together at the end of the run and the buffer keeps its capacity,
+   // so adding an object does not allocate memory.
+   struct temp_object {
+      void *obj;
+      vm::field_type kind;
+      vm::type *type;
+   };
+   std::vector<temp_object, mem::allocator<temp_object>> temp_objects;
 
    void purge_runtime_objects();
    full_tuple *search_for_negative_tuple(vm::full_tuple_list*, full_tuple *);
@@ -140,6 +138,9 @@ public:
 #endif
 #ifdef FACT_BUFFERING
    vm::buffer facts_to_send;
+   // batch for each thread that owns nodes in 'facts_to_send'.
+   std::vector<vm::thread_batch*, mem::allocator<vm::thread_batch*>> thread_batches;
+   std::vector<size_t, mem::allocator<size_t>> batch_threads;
 #endif
 #ifdef COORDINATION_BUFFERING
    using map_set_priority = std::unordered_map<
@@ -206,23 +207,23 @@ public:
 
    inline void add_cons(runtime::cons *ls, vm::list_type *t) {
       ls->inc_refs();
-      free_cons.push_back(std::make_pair(ls, t));
+      temp_objects.push_back({ls, FIELD_LIST, t});
    }
    inline void add_array(runtime::array *x, vm::type *t) {
       x->inc_refs();
-      free_array.push_back(std::make_pair(x, t));
+      temp_objects.push_back({x, FIELD_ARRAY, t});
    }
    inline void add_set(runtime::set *x, vm::type *t) {
       x->inc_refs();
-      free_set.push_back(std::make_pair(x, t));
+      temp_objects.push_back({x, FIELD_SET, t});
    }
    inline void add_string(runtime::rstring::ptr str) {
       str->inc_refs();
-      free_rstring.push_back(str);
+      temp_objects.push_back({str, FIELD_STRING, nullptr});
    }
    inline void add_struct(runtime::struct1 *s, vm::struct_type *t) {
       s->inc_refs();
-      free_struct1.push_back(std::make_pair(s, t));
+      temp_objects.push_back({s, FIELD_STRUCT, t});
    }
 
    void add_to_aggregate(db::node *, vm::full_tuple_list *, full_tuple *);